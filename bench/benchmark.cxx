@@ -1,5 +1,12 @@
 #define ANKERL_NANOBENCH_IMPLEMENT
+#include <cmath>
+#include <filesystem>
+#include <fstream>
 #include <ranges>
+#include <sstream>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
 #include <rivers/rivers.hpp>
 #include "nanobench.h"
 #include "flow.hpp"
@@ -70,6 +77,173 @@ int main() {
             an::doNotOptimizeAway(r.sum());
         });
 
+    // filtering at different selectivities, over values that are spread
+    // out so that the branch on the predicate is hard to predict
+    std::vector<int> percents(1'000'000);
+    for (std::size_t i = 0; i != percents.size(); ++i) {
+        percents[i] = int((i * 2654435761u) % 100);
+    }
+
+    for (int selectivity : {10, 50, 90}) {
+        auto keep = [=](int x) { return x < selectivity; };
+        auto suffix = "_" + std::to_string(selectivity);
+
+        bench.run("filter_handwritten" + suffix,
+            [&]{
+                int res = 0;
+                for (int i : percents) {
+                    if (keep(i)) {
+                        res += i;
+                    }
+                }
+                an::doNotOptimizeAway(res);
+            });
+
+        bench.run("filter_rivers" + suffix,
+            [&]{
+                an::doNotOptimizeAway(rvr::from(percents).filter(keep).sum());
+            });
+
+        bench.run("filter_into_vec_rivers" + suffix,
+            [&]{
+                an::doNotOptimizeAway(rvr::from(percents).filter(keep).into_vec());
+            });
+    }
+
+    // parsing whitespace-separated numbers out of a stream
+    std::string ints_text;
+    for (int i : percents) {
+        ints_text += std::to_string(i);
+        ints_text += ' ';
+    }
+
+    bench.run("parse_from_stream_rivers", [&]{
+        std::istringstream iss(ints_text);
+        an::doNotOptimizeAway(rvr::from_stream<int>(iss).sum());
+    });
+
+    bench.run("parse_parse_stream_rivers", [&]{
+        std::istringstream iss(ints_text);
+        an::doNotOptimizeAway(rvr::parse_stream<int>(iss).sum());
+    });
+
+    // parsing overlapped with more expensive work downstream
+    auto crunch = [](int x) {
+        double d = x;
+        for (int k = 0; k != 20; ++k) {
+            d = std::sqrt(d + k);
+        }
+        return d;
+    };
+
+    bench.run("parse_crunch_rivers", [&]{
+        std::istringstream iss(ints_text);
+        an::doNotOptimizeAway(rvr::parse_stream<int>(iss).map(crunch).fold(0.0, std::plus()));
+    });
+
+    bench.run("parse_crunch_async_buffer_rivers", [&]{
+        std::istringstream iss(ints_text);
+        an::doNotOptimizeAway(rvr::parse_stream<int>(iss).async_buffer().map(crunch).fold(0.0, std::plus()));
+    });
+
+    bench.run("parse_crunch_par_map_rivers", [&]{
+        std::istringstream iss(ints_text);
+        an::doNotOptimizeAway(rvr::parse_stream<int>(iss).par_map(crunch).fold(0.0, std::plus()));
+    });
+
+    // splitting a buffer into lines, with one and two character delimiters
+    std::string lines_text;
+    for (int i = 0; i != 100'000; ++i) {
+        lines_text.append(20 + i % 40, 'x');
+        lines_text += "\r\n";
+    }
+
+    bench.run("split_lines_rivers", [&]{
+        an::doNotOptimizeAway(rvr::from(lines_text).split('\n').count());
+    });
+
+    bench.run("split_crlf_lines_rivers", [&]{
+        an::doNotOptimizeAway(rvr::from(lines_text).split("\r\n").count());
+    });
+
+    bench.run("split_lines_collect_rivers", [&]{
+        an::doNotOptimizeAway(rvr::from(lines_text).split('\n').map(rvr::collect<std::string>).into_vec());
+    });
+
+    bench.run("split_views_lines_collect_rivers", [&]{
+        an::doNotOptimizeAway(rvr::from(lines_text).split_views('\n').into_vec());
+    });
+
+    bench.run("tokenize_lines_rivers", [&]{
+        an::doNotOptimizeAway(rvr::from(lines_text).tokenize(rvr::char_class::space()).count());
+    });
+
+    // parsing CSV, where every fifth record has a quoted field
+    std::string csv_text;
+    for (int i = 0; i != 100'000; ++i) {
+        csv_text += std::to_string(i) + ",hello world,";
+        csv_text += i % 5 == 0 ? "\"quoted, \"\"x\"\"\"" : "plain";
+        csv_text += ",3.14159,some longer text field here\n";
+    }
+
+    bench.run("csv_fields_rivers", [&]{
+        std::size_t fields = 0;
+        rvr::csv(csv_text).for_each([&](rvr::CsvRow row){ fields += row.size(); });
+        an::doNotOptimizeAway(fields);
+    });
+
+    // counting the lines in a file, mapped or read ahead in blocks
+    auto const lines_path = std::filesystem::temp_directory_path() / "rivers_bench_lines.txt";
+    std::ofstream(lines_path, std::ios::binary) << lines_text;
+
+    bench.run("file_lines_from_file_rivers", [&]{
+        an::doNotOptimizeAway(rvr::from_file<char>(lines_path).filter([](char c){ return c == '\n'; }).count());
+    });
+
+    bench.run("file_lines_read_ahead_rivers", [&]{
+        std::size_t lines = 0;
+        rvr::read_ahead(lines_path).for_each([&](std::span<std::byte const> block){
+            lines += std::count(block.begin(), block.end(), std::byte('\n'));
+        });
+        an::doNotOptimizeAway(lines);
+    });
+    std::filesystem::remove(lines_path);
+
+    // writing numbers out as text
+    int const null_fd = ::open("/dev/null", O_WRONLY);
+
+    bench.run("write_lines_fmt", [&]{
+        auto const text = fmt::format("{}\n", fmt::join(bunch_of_ints, "\n"));
+        an::doNotOptimizeAway(::write(null_fd, text.data(), text.size()));
+    });
+
+    bench.run("write_lines_rivers", [&]{
+        an::doNotOptimizeAway(rvr::write_lines(rvr::from(bunch_of_ints), null_fd));
+    });
+    ::close(null_fd);
+
+    // selecting a tenth of the elements
+    auto every_tenth = [](int x) { return x % 10 == 0; };
+
+    bench.run("filter_into_vec_rivers", [&]{
+        an::doNotOptimizeAway(rvr::from(bunch_of_ints).filter(every_tenth).into_vec());
+    });
+
+    bench.run("filter_into_vec_par_rivers", [&]{
+        an::doNotOptimizeAway(rvr::from(bunch_of_ints).par().filter(every_tenth).into_vec());
+    });
+
+    // finding an element near the start, where the other pieces can stop
+    auto early = bunch_of_ints[bunch_of_ints.size() / 100];
+
+    bench.run("find_early_rivers", [&]{
+        an::doNotOptimizeAway(rvr::from(bunch_of_ints).find([&](int x){ return x == early; }));
+    });
+
+    bench.run("find_early_par_rivers", [&]{
+        an::doNotOptimizeAway(rvr::from(bunch_of_ints).par().find([&](int x){ return x == early; }));
+    });
+
     auto moar_ints = bunch_of_ints;
     std::reverse(moar_ints.begin(), moar_ints.end());
 
@@ -0,0 +1,326 @@
+#ifndef RIVERS_ASYNC_BUFFER_HPP
+#define RIVERS_ASYNC_BUFFER_HPP
+
+#include <rivers/core.hpp>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <new>
+#include <thread>
+#if __has_include(<linux/membarrier.h>)
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace rvr {
+
+////////////////////////////////////////////////////////////////////////////
+// async_buffer: takes a (RiverOf<T> r, size_t n) and produces a RiverOf<T>
+// with the same elements, except that r is run on a thread of its own, up to
+// n elements ahead of whatever is consuming the result. This overlaps
+// everything upstream (like reading and parsing input) with everything
+// downstream.
+// The two threads share a bounded single-producer/single-consumer ring of
+// n elements (rounded up to a power of two). The consumer takes whatever is
+// ready in one go and only hands the freed space back every n / 8 elements,
+// so neither side touches the other's cache lines for every element. A side
+// that has to wait spins for a while - for longer, the more often spinning
+// has paid off - and then sleeps on a futex (via std::atomic::wait). Going
+// to sleep is what pays for the fence that makes this safe (see
+// sleep_fence), so that the producer only has to glance at a flag that's
+// on a cache line of its own for every element.
+// The producer thread is started when the river is first used, and is told
+// to stop (and joined) when the river is destroyed - so ending early, as in
+// r.async_buffer().any(p), stops the upstream river too. Elements are moved
+// across, so the result produces values (value_t<R>) rather than references.
+// If r throws, the exception is rethrown on the consumer's side, once the
+// elements before it have been consumed.
+////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+    inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+
+    // whether waiting by spinning can pay off at all: with only one hardware
+    // thread, it would just hold up whoever is being waited on
+    inline auto can_spin() -> bool {
+        static bool const multicore = std::thread::hardware_concurrency() > 1;
+        return multicore;
+    }
+
+    // Whether membarrier(2) is there, and this process has registered to
+    // use it - which it does the first time anyone asks
+    inline auto has_membarrier() -> bool {
+#if __has_include(<linux/membarrier.h>)
+        static bool const registered =
+            ::syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) == 0;
+        return registered;
+#else
+        return false;
+#endif
+    }
+
+    // A pair of fences that order a store before a later load on both sides,
+    // as a seq_cst fence on each side would: one for the side going to sleep
+    // (after saying so, and before checking once more whether it has to),
+    // and one for the side waking it (after making what it waits for true,
+    // and before checking whether it's asleep). With membarrier, the first
+    // runs a full barrier on every thread of the process that's running, so
+    // that the second - which runs far more often - only has to stop the
+    // compiler from reordering.
+    inline void sleep_fence() {
+#if __has_include(<linux/membarrier.h>)
+        if (has_membarrier()) {
+            ::syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0);
+            return;
+        }
+#endif
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    inline void wake_fence() {
+        if (has_membarrier()) {
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+        } else {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    // One side's way of waiting for the other. It spins, and then goes to
+    // sleep on epoch, having set sleeping so that the other side knows it
+    // has to wake it - which the other side does by calling wake() after
+    // making whatever it was waiting for true.
+    class spsc_waiter {
+        std::atomic<std::uint32_t> epoch = 0;
+        std::atomic<bool> sleeping = false;
+        std::uint32_t spins = 128;
+
+        static constexpr std::uint32_t min_spins = 16;
+        static constexpr std::uint32_t max_spins = 8192;
+
+    public:
+        // waits until ready(), which has to read with at least acquire
+        // semantics whatever the other side writes before calling wake()
+        template <typename P>
+        void wait_until(P ready) {
+            if (can_spin()) {
+                for (std::uint32_t i = 0; i != spins; ++i) {
+                    if (ready()) {
+                        spins = std::min(spins * 2, max_spins);
+                        return;
+                    }
+                    cpu_relax();
+                }
+                spins = std::max(spins / 2, min_spins);
+            }
+
+            for (;;) {
+                auto const seen = epoch.load(std::memory_order_seq_cst);
+                sleeping.store(true, std::memory_order_seq_cst);
+                sleep_fence();
+                if (ready()) {
+                    sleeping.store(false, std::memory_order_relaxed);
+                    return;
+                }
+                epoch.wait(seen, std::memory_order_seq_cst);
+                sleeping.store(false, std::memory_order_relaxed);
+            }
+        }
+
+        // wakes the waiting side, if it's asleep. Only the first call after
+        // it went to sleep has to notify, so this clears sleeping too. When
+        // nobody is asleep, this is just a load of sleeping - which only
+        // changes when the other side goes to sleep
+        void wake() {
+            wake_fence();
+            if (sleeping.load(std::memory_order_relaxed)
+                and sleeping.exchange(false, std::memory_order_seq_cst)) {
+                epoch.fetch_add(1, std::memory_order_seq_cst);
+                epoch.notify_one();
+            }
+        }
+
+        // wakes the waiting side, even if it's only about to go to sleep
+        void wake_always() {
+            epoch.fetch_add(1, std::memory_order_seq_cst);
+            epoch.notify_one();
+        }
+    };
+
+    // The state shared between an AsyncBuffer and its producer thread. The
+    // producer writes tail, and the consumer writes head - each on its own
+    // cache line, along with the other's copy of it. The consumer only reads
+    // tail once it has run out of elements, so storing it for every element
+    // stays on the producer's cache line until then. Each waiter is on a
+    // line of its own too, since the other side reads it to wake it.
+    template <River R>
+    class spsc_ring {
+        using T = value_t<R>;
+
+        struct slot {
+            alignas(T) std::byte bytes[sizeof(T)];
+        };
+
+        R base;
+        std::size_t mask;
+        std::size_t batch;
+        std::unique_ptr<slot[]> slots;
+        std::exception_ptr error;
+        std::thread producer;
+        std::atomic<bool> stopping = false;
+
+        alignas(64) std::atomic<std::size_t> tail = 0;
+        std::atomic<bool> finished = false;
+        std::size_t head_seen = 0;    // the producer's copy of head
+
+        alignas(64) std::atomic<std::size_t> head = 0;
+        std::size_t next = 0;         // the next element to consume
+        std::size_t tail_seen = 0;    // the consumer's copy of tail
+
+        alignas(64) spsc_waiter producer_waiter;  // for the producer to wait on
+        alignas(64) spsc_waiter consumer_waiter;  // for the consumer to wait on
+
+        auto at(std::size_t i) -> T* {
+            return std::launder(reinterpret_cast<T*>(slots[i & mask].bytes));
+        }
+
+        // hands the space of everything consumed so far back to the producer
+        void release() {
+            head.store(next, std::memory_order_release);
+            producer_waiter.wake();
+        }
+
+        void produce() {
+            std::size_t t = 0;
+            try {
+                base.while_([&](reference_t<R> elem){
+                    if (t - head_seen == mask + 1) {
+                        producer_waiter.wait_until([&]{
+                            head_seen = head.load(std::memory_order_acquire);
+                            return t - head_seen != mask + 1
+                                or stopping.load(std::memory_order_relaxed);
+                        });
+                        if (stopping.load(std::memory_order_relaxed)) {
+                            return false;
+                        }
+                    }
+                    ::new (slots[t & mask].bytes) T(RVR_FWD(elem));
+                    tail.store(++t, std::memory_order_release);
+                    consumer_waiter.wake();
+                    return not stopping.load(std::memory_order_relaxed);
+                });
+            } catch (...) {
+                error = std::current_exception();
+            }
+            finished.store(true, std::memory_order_release);
+            consumer_waiter.wake();
+        }
+
+    public:
+        spsc_ring(R base, std::size_t capacity)
+            : base(std::move(base))
+            , mask(std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1)
+            , batch(std::max<std::size_t>((mask + 1) / 8, 1))
+            , slots(new slot[mask + 1])
+        { }
+
+        spsc_ring(spsc_ring const&) = delete;
+        auto operator=(spsc_ring const&) -> spsc_ring& = delete;
+
+        ~spsc_ring() {
+            if (producer.joinable()) {
+                stopping.store(true, std::memory_order_seq_cst);
+                producer_waiter.wake_always();
+                producer.join();
+            }
+            for (std::size_t const t = tail.load(std::memory_order_relaxed); next != t; ++next) {
+                std::destroy_at(at(next));
+            }
+        }
+
+        template <typename P>
+        auto while_(P& pred) -> bool {
+            if (not producer.joinable()) {
+                producer = std::thread([this]{ produce(); });
+            }
+
+            for (;;) {
+                if (next == tail_seen) {
+                    // let the producer carry on while we wait
+                    release();
+                    consumer_waiter.wait_until([&]{
+                        tail_seen = tail.load(std::memory_order_acquire);
+                        return next != tail_seen or finished.load(std::memory_order_acquire);
+                    });
+                    // check again, since it could have finished after
+                    // producing more
+                    tail_seen = tail.load(std::memory_order_acquire);
+                    if (next == tail_seen) {
+                        if (error) {
+                            std::rethrow_exception(std::exchange(error, nullptr));
+                        }
+                        return true;
+                    }
+                }
+
+                T* const p = at(next);
+                T value = std::move(*p);
+                std::destroy_at(p);
+                if (++next - head.load(std::memory_order_relaxed) >= batch) {
+                    release();
+                }
+                if (not std::invoke(pred, std::move(value))) {
+                    return false;
+                }
+            }
+        }
+    };
+}
+
+template <River R>
+    requires std::move_constructible<value_t<R>>
+struct AsyncBuffer : RiverBase<AsyncBuffer<R>>
+{
+private:
+    std::unique_ptr<detail::spsc_ring<R>> ring;
+
+public:
+    using reference = value_t<R>;
+
+    AsyncBuffer(R base, std::size_t n)
+        : ring(std::make_unique<detail::spsc_ring<R>>(std::move(base), n))
+    { }
+
+    auto while_(PredicateFor<reference> auto&& pred) -> bool {
+        return ring->while_(pred);
+    }
+};
+
+struct {
+    template <River R>
+    auto operator()(R&& r, std::size_t n = 1024) const {
+        return AsyncBuffer<std::remove_cvref_t<R>>(RVR_FWD(r), n);
+    }
+} inline constexpr async_buffer;
+
+template <typename Derived>
+auto RiverBase<Derived>::async_buffer(std::size_t n) & {
+    return AsyncBuffer<Derived>(self(), n);
+}
+
+template <typename Derived>
+auto RiverBase<Derived>::async_buffer(std::size_t n) && {
+    return AsyncBuffer<Derived>(std::move(self()), n);
+}
+
+}
+
+#endif
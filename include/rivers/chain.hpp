@@ -2,14 +2,131 @@
 #define RIVERS_CHAIN_HPP
 
 #include <rivers/core.hpp>
+#include <tuple>
+#include <variant>
 
 namespace rvr {
 
 ////////////////////////////////////////////////////////////////////////////
 // chain: takes N RiverOf<T>'s and produces a single RiverOf<T> that consumes
 // them sequentially
+// A Chain can be split: between its bases if it has more than one left,
+// otherwise within its only base (if that can be split). The split off
+// prefix is a Chain of detail::chain_parts, which only holds the bases it
+// consumes - moved over from this Chain, or split off its only base - so
+// that splitting never copies a base.
 ////////////////////////////////////////////////////////////////////////////
 
+template <River... Rs>
+    requires requires {
+        typename std::common_reference_t<reference_t<Rs>...>;
+    }
+struct Chain;
+
+namespace detail {
+    template <River R>
+    struct chain_piece_of {
+        using type = R;
+    };
+
+    template <SplittableRiver R>
+    struct chain_piece_of<R> {
+        using type = split_t<R>;
+    };
+
+    // One of the bases of a split off Chain: either a whole base, moved
+    // over from the Chain it was split off, or a piece split off one, or
+    // nothing (for the bases that stayed behind).
+    template <River R>
+    struct chain_part : RiverBase<chain_part<R>>
+    {
+    private:
+        using piece_t = typename chain_piece_of<R>::type;
+
+        std::variant<std::monostate, R, piece_t> part;
+
+        // invokes f on whatever we hold, or returns empty if nothing
+        template <typename F, typename T>
+        constexpr auto visit(F&& f, T empty) {
+            return std::visit([&]<typename P>(P& p) -> T {
+                if constexpr (std::same_as<P, std::monostate>) {
+                    return empty;
+                } else {
+                    return f(p);
+                }
+            }, part);
+        }
+
+    public:
+        using reference = std::common_reference_t<reference_t<R>, reference_t<piece_t>>;
+
+        constexpr chain_part() = default;
+
+        template <std::size_t I, typename T>
+        constexpr chain_part(std::in_place_index_t<I> i, T&& r)
+            : part(i, RVR_FWD(r))
+        { }
+
+        constexpr auto while_(PredicateFor<reference> auto&& pred) -> bool {
+            return visit([&](auto& r){ return r.while_(pred); }, true);
+        }
+
+        constexpr void for_all(std::invocable<reference> auto&& op)
+            requires ExhaustiveRiver<R> and ExhaustiveRiver<piece_t>
+        {
+            visit([&](auto& r){
+                r.for_all(op);
+                return true;
+            }, true);
+        }
+
+        constexpr auto while_chunk(PredicateFor<chunk_t<chain_part>> auto&& pred) -> bool
+            requires ChunkedRiver<R> and ChunkedRiver<piece_t>
+                 and std::same_as<value_t<R>, value_t<chain_part>>
+                 and std::same_as<value_t<piece_t>, value_t<chain_part>>
+        {
+            return visit([&](auto& r){ return r.while_chunk(pred); }, true);
+        }
+
+        constexpr auto size_hint() const -> SizeHint {
+            return std::visit([]<typename P>(P const& p){
+                if constexpr (std::same_as<P, std::monostate>) {
+                    return SizeHint::exactly(0);
+                } else {
+                    return rvr::size_hint(p);
+                }
+            }, part);
+        }
+
+        constexpr auto advance(std::size_t n) -> std::size_t
+            requires AdvanceableRiver<R> and AdvanceableRiver<piece_t>
+        {
+            return visit([&](auto& r){ return r.advance(n); }, std::size_t(0));
+        }
+
+        constexpr auto try_split() -> tl::optional<chain_part>
+            requires SplittableRiver<R> and SplittableRiver<piece_t>
+                 and std::convertible_to<split_t<piece_t>, piece_t>
+        {
+            return visit([&](auto& r){
+                return r.try_split().map([](auto&& prefix){
+                    return chain_part(std::in_place_index<2>, piece_t(std::move(prefix)));
+                });
+            }, tl::optional<chain_part>());
+        }
+    };
+
+    template <typename R>
+    struct chain_part_of {
+        using type = chain_part<R>;
+    };
+
+    template <typename R>
+    struct chain_part_of<chain_part<R>> {
+        using type = chain_part<R>;
+    };
+}
+
 template <River... Rs>
     requires requires {
         typename std::common_reference_t<reference_t<Rs>...>;
@@ -17,7 +134,81 @@ template <River... Rs>
 struct Chain : RiverBase<Chain<Rs...>>
 {
 private:
+    template <River... Ss>
+        requires requires {
+            typename std::common_reference_t<reference_t<Ss>...>;
+        }
+    friend struct Chain;
+
+    using Prefix = Chain<typename detail::chain_part_of<Rs>::type...>;
+
+    template <std::size_t I>
+    using base_t = std::tuple_element_t<I, std::tuple<Rs...>>;
+
+    template <std::size_t I>
+    using part_t = std::tuple_element_t<I, std::tuple<typename detail::chain_part_of<Rs>::type...>>;
+
     std::tuple<Rs...> bases;
+    std::size_t first = 0;
+    std::size_t last = sizeof...(Rs);
+
+    // Invokes f on each of our active bases in order, until one returns false
+    template <typename F>
+    constexpr auto all_active(F&& f) -> bool {
+        return [&]<std::size_t... I>(std::index_sequence<I...>){
+            return ((I < first or I >= last or f(std::get<I>(bases))) and ...);
+        }(std::index_sequence_for<Rs...>());
+    }
+
+    // Our base I, moved into a part of a Prefix
+    template <std::size_t I>
+    constexpr auto move_part() -> part_t<I> {
+        if constexpr (std::same_as<base_t<I>, part_t<I>>) {
+            return std::move(std::get<I>(bases));
+        } else {
+            return part_t<I>(std::in_place_index<1>, std::move(std::get<I>(bases)));
+        }
+    }
+
+    // The Prefix that consumes the bases in [from, to), made by make(J)
+    // for each of them
+    template <typename F>
+    constexpr auto prefix(std::size_t from, std::size_t to, F make) -> Prefix {
+        return [&]<std::size_t... J>(std::index_sequence<J...>){
+            Prefix prefix(((J >= from and J < to) ? make.template operator()<J>() : part_t<J>())...);
+            prefix.first = from;
+            prefix.last = to;
+            return prefix;
+        }(std::index_sequence_for<Rs...>());
+    }
+
+    // Splits our base I, if it is the active one
+    template <std::size_t I = 0>
+    constexpr auto split_active_base() -> tl::optional<Prefix> {
+        if constexpr (I == sizeof...(Rs)) {
+            return tl::nullopt;
+        } else {
+            using B = base_t<I>;
+            if (I != first) {
+                return split_active_base<I + 1>();
+            }
+
+            if constexpr (SplittableRiver<B>) {
+                if (auto piece = std::get<I>(bases).try_split()) {
+                    return prefix(I, I + 1, [&]<std::size_t J>() -> part_t<J> {
+                        if constexpr (J != I) {
+                            return part_t<J>();
+                        } else if constexpr (std::same_as<split_t<B>, part_t<J>>) {
+                            return std::move(*piece);
+                        } else {
+                            return part_t<J>(std::in_place_index<2>, std::move(*piece));
+                        }
+                    });
+                }
+            }
+            return tl::nullopt;
+        }
+    }
 
 public:
     using reference = std::common_reference_t<reference_t<Rs>...>;
@@ -25,11 +216,72 @@ public:
     constexpr Chain(Rs... bases) : bases(std::move(bases)...) { }
 
     constexpr auto while_(PredicateFor<reference> auto&& pred) -> bool {
-        return std::apply([&](Rs&... rs){
-            return (rs.while_(pred) and ...);
+        return all_active([&](auto& r){
+            return r.while_(pred);
+        });
+    }
+
+    constexpr void for_all(std::invocable<reference> auto&& op)
+        requires (ExhaustiveRiver<Rs> and ...)
+    {
+        all_active([&](auto& r){
+            r.for_all(op);
+            return true;
+        });
+    }
+
+    constexpr auto while_chunk(PredicateFor<chunk_t<Chain>> auto&& pred) -> bool
+        requires (ChunkedRiver<Rs> and ...)
+             and (std::same_as<value_t<Rs>, value_t<Chain>> and ...)
+    {
+        return all_active([&](auto& r){
+            return r.while_chunk(pred);
+        });
+    }
+
+    constexpr auto size_hint() const -> SizeHint {
+        return std::apply([this](Rs const&... rs){
+            SizeHint const hints[] = {rvr::size_hint(rs)...};
+            SizeHint total = {.upper=0};
+            for (std::size_t i = first; i != last; ++i) {
+                SizeHint const& hint = hints[i];
+                total.lower += hint.lower;
+                if (total.upper and hint.upper) {
+                    *total.upper += *hint.upper;
+                } else {
+                    total.upper = tl::nullopt;
+                }
+            }
+            return total;
         }, bases);
     }
 
+    constexpr auto advance(std::size_t n) -> std::size_t
+        requires (AdvanceableRiver<Rs> and ...)
+    {
+        std::size_t skipped = 0;
+        all_active([&](auto& r){
+            skipped += r.advance(n - skipped);
+            return skipped != n;
+        });
+        return skipped;
+    }
+
+    constexpr auto try_split() -> tl::optional<Prefix>
+        requires (std::move_constructible<Rs> and ...)
+    {
+        if (last - first >= 2) {
+            std::size_t const mid = first + (last - first) / 2;
+            auto const from = std::exchange(first, mid);
+            return prefix(from, mid, [&]<std::size_t J>(){ return move_part<J>(); });
+        }
+
+        if (last - first == 1) {
+            return split_active_base();
+        }
+        return tl::nullopt;
+    }
+
     void reset() requires (ResettableRiver<Rs> and ...)
     {
         std::apply([&](Rs&... rs){
@@ -54,7 +306,7 @@ constexpr auto RiverBase<Derived>::chain(Rs&&... rs) & {
 template <typename Derived>
 template <River... Rs>
 constexpr auto RiverBase<Derived>::chain(Rs&&... rs) && {
-    return Chain(RVR_FWD(self()), RVR_FWD(rs)...);
+    return Chain(std::move(self()), RVR_FWD(rs)...);
 }
 
 }
@@ -0,0 +1,469 @@
+#ifndef RIVERS_CHANNEL_HPP
+#define RIVERS_CHANNEL_HPP
+
+#include <rivers/core.hpp>
+#include <rivers/async_buffer.hpp>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+
+namespace rvr {
+
+////////////////////////////////////////////////////////////////////////////
+// channel<T>: a River of T fed from any number of threads.
+// ch.producer() hands out a channel_producer<T>, which pushes elements into
+// a bounded lock-free queue of ch's capacity (rounded up to a power of two):
+// * p.push(v) waits while the queue is full
+// * p.try_push(v) doesn't wait, and leaves v alone if it fails
+// * p.close() (or destroying p) says that p won't push any more
+// Both return false, without waiting, once every consumer is gone.
+// The channel itself is the consumer side: its while_ waits until there are
+// elements, and the river ends once the queue is empty and every producer
+// has closed. Until the first producer is handed out (or ch.close() says
+// there won't be any), the channel counts as a producer itself, so that
+// consuming it waits rather than ending right away. Copies of a channel
+// consume from the same queue, each taking a share of the elements.
+// Consumers take every ready element (up to an eighth of the queue) with a
+// single compare-and-swap, and only wake waiting producers once per batch.
+// Whatever a consumer has taken but not used when it stops early is kept
+// for its next use, and put back when it's destroyed: into the queue, if
+// nobody has taken anything since, or else onto a list of leftovers that
+// every consumer takes from first.
+////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+    // Like spsc_waiter, except that any number of threads can wait (and
+    // wake) at once. So it can't keep track of how long spinning tends to
+    // take, and waking has to wake everyone.
+    class mpmc_waiter {
+        std::atomic<std::uint32_t> epoch = 0;
+        std::atomic<bool> sleeping = false;
+
+        static constexpr int spins = 256;
+
+    public:
+        template <typename P>
+        void wait_until(P ready) {
+            if (can_spin()) {
+                for (int i = 0; i != spins; ++i) {
+                    if (ready()) {
+                        return;
+                    }
+                    cpu_relax();
+                }
+            }
+
+            for (;;) {
+                // sleeping is left set on the way out, since someone else
+                // may still be asleep
+                auto const seen = epoch.load(std::memory_order_seq_cst);
+                sleeping.store(true, std::memory_order_seq_cst);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (ready()) {
+                    return;
+                }
+                epoch.wait(seen, std::memory_order_seq_cst);
+            }
+        }
+
+        void wake() {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (sleeping.load(std::memory_order_relaxed)
+                and sleeping.exchange(false, std::memory_order_seq_cst)) {
+                epoch.fetch_add(1, std::memory_order_seq_cst);
+                epoch.notify_all();
+            }
+        }
+    };
+
+    // A bounded MPMC queue, as in Vyukov's: every cell has a sequence
+    // number, which is i when cell i is free to be pushed into and i + 1
+    // once it holds element i (for i counting up forever).
+    template <typename T>
+    class channel_state {
+        struct cell {
+            std::atomic<std::size_t> seq;
+            alignas(T) std::byte bytes[sizeof(T)];
+        };
+
+        std::size_t mask;
+        std::unique_ptr<cell[]> cells;
+
+        alignas(64) std::atomic<std::size_t> enqueue_pos = 0;
+        alignas(64) std::atomic<std::size_t> dequeue_pos = 0;
+        // starts at one for the channel itself, until the first producer
+        // is handed out or the channel is closed
+        alignas(64) std::atomic<std::size_t> producers = 1;
+        std::atomic<bool> pending = true;
+        std::atomic<std::size_t> consumers = 0;
+        detail::mpmc_waiter data;   // for consumers to wait on
+        detail::mpmc_waiter space;  // for producers to wait on
+
+        // elements that were claimed but couldn't be given back to the queue
+        std::mutex leftovers_lock;
+        std::deque<T> leftovers;
+        std::atomic<std::size_t> leftover_count = 0;
+
+        auto at(std::size_t i) -> cell& {
+            return cells[i & mask];
+        }
+
+        static auto element(cell& c) -> T* {
+            return std::launder(reinterpret_cast<T*>(c.bytes));
+        }
+
+    public:
+        explicit channel_state(std::size_t capacity)
+            : mask(std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1)
+            , cells(new cell[mask + 1])
+        {
+            for (std::size_t i = 0; i != mask + 1; ++i) {
+                cells[i].seq.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        channel_state(channel_state const&) = delete;
+        auto operator=(channel_state const&) -> channel_state& = delete;
+
+        ~channel_state() {
+            std::size_t const end = enqueue_pos.load(std::memory_order_relaxed);
+            for (std::size_t i = dequeue_pos.load(std::memory_order_relaxed); i != end; ++i) {
+                std::destroy_at(element(at(i)));
+            }
+        }
+
+        void add_producer() {
+            producers.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void remove_producer() {
+            if (producers.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                data.wake();
+            }
+        }
+
+        // the channel stops counting as a producer itself
+        void close() {
+            if (pending.exchange(false, std::memory_order_acq_rel)) {
+                remove_producer();
+            }
+        }
+
+        void add_consumer() {
+            consumers.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void remove_consumer() {
+            if (consumers.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                space.wake();
+            }
+        }
+
+        // pushes T(RVR_FWD(value)), unless nobody is consuming or (if not
+        // wait) the queue is full
+        template <typename U>
+        auto push(U&& value, bool wait) -> bool {
+            std::size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+            for (;;) {
+                if (consumers.load(std::memory_order_relaxed) == 0) {
+                    return false;
+                }
+
+                cell& c = at(pos);
+                std::size_t const seq = c.seq.load(std::memory_order_acquire);
+                auto const diff = static_cast<std::intptr_t>(seq - pos);
+                if (diff == 0) {
+                    if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        ::new (c.bytes) T(RVR_FWD(value));
+                        c.seq.store(pos + 1, std::memory_order_release);
+                        data.wake();
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    // full, until the element in this cell is consumed
+                    if (not wait) {
+                        return false;
+                    }
+                    space.wait_until([&]{
+                        return c.seq.load(std::memory_order_acquire) != seq
+                            or consumers.load(std::memory_order_relaxed) == 0;
+                    });
+                    pos = enqueue_pos.load(std::memory_order_relaxed);
+                } else {
+                    // another producer got this cell first
+                    pos = enqueue_pos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Claims the next batch of elements, [first, last), waiting for
+        // there to be some. Returns false if there are none and never will be.
+        auto claim(std::size_t& first, std::size_t& last) -> bool {
+            std::size_t const batch = std::max<std::size_t>((mask + 1) / 8, 1);
+            std::size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+            for (;;) {
+                if (leftover_count.load(std::memory_order_acquire) != 0) {
+                    return false;
+                }
+
+                std::size_t n = 0;
+                while (n != batch and at(pos + n).seq.load(std::memory_order_acquire) == pos + n + 1) {
+                    ++n;
+                }
+                if (n != 0) {
+                    if (dequeue_pos.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed)) {
+                        first = pos;
+                        last = pos + n;
+                        return true;
+                    }
+                    continue;
+                }
+
+                cell& c = at(pos);
+                if (c.seq.load(std::memory_order_acquire) != pos) {
+                    // another consumer got this cell first
+                    pos = dequeue_pos.load(std::memory_order_relaxed);
+                    continue;
+                }
+
+                // empty. Every push happens before its producer closes, so
+                // if they all have and this cell is still empty, that's it
+                if (producers.load(std::memory_order_acquire) == 0
+                    and c.seq.load(std::memory_order_acquire) == pos) {
+                    return false;
+                }
+                data.wait_until([&]{
+                    return c.seq.load(std::memory_order_acquire) != pos
+                        or producers.load(std::memory_order_acquire) == 0
+                        or dequeue_pos.load(std::memory_order_relaxed) != pos
+                        or leftover_count.load(std::memory_order_acquire) != 0;
+                });
+                pos = dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        // moves out claimed element i, freeing its cell
+        auto take(std::size_t i) -> T {
+            cell& c = at(i);
+            T* const p = element(c);
+            T value = std::move(*p);
+            std::destroy_at(p);
+            c.seq.store(i + mask + 1, std::memory_order_release);
+            return value;
+        }
+
+        // Gives back [first, last), the end of the last batch claimed,
+        // if nobody has claimed anything since. Returns whether it could.
+        auto unclaim(std::size_t first, std::size_t last) -> bool {
+            if (dequeue_pos.compare_exchange_strong(last, first, std::memory_order_relaxed)) {
+                data.wake();
+                return true;
+            }
+            return false;
+        }
+
+        // Gives back [first, last) one way or another: to the queue if it
+        // can, or else to the leftovers
+        void put_back(std::size_t first, std::size_t last) {
+            if (first == last or unclaim(first, last)) {
+                return;
+            }
+            {
+                std::lock_guard lock(leftovers_lock);
+                for (; first != last; ++first) {
+                    leftovers.push_back(take(first));
+                }
+                leftover_count.store(leftovers.size(), std::memory_order_release);
+            }
+            freed();
+            data.wake();
+        }
+
+        // takes one of the leftovers, if there are any
+        auto take_leftover() -> tl::optional<T> {
+            if (leftover_count.load(std::memory_order_acquire) == 0) {
+                return tl::nullopt;
+            }
+            std::lock_guard lock(leftovers_lock);
+            if (leftovers.empty()) {
+                return tl::nullopt;
+            }
+            tl::optional<T> value(std::move(leftovers.front()));
+            leftovers.pop_front();
+            leftover_count.store(leftovers.size(), std::memory_order_release);
+            return value;
+        }
+
+        // wakes producers waiting on cells that have been freed
+        void freed() {
+            space.wake();
+        }
+    };
+}
+
+template <std::move_constructible T>
+class channel;
+
+template <std::move_constructible T>
+class channel_producer {
+    std::shared_ptr<detail::channel_state<T>> state;
+
+    friend class channel<T>;
+
+    explicit channel_producer(std::shared_ptr<detail::channel_state<T>> s)
+        : state(std::move(s))
+    {
+        state->add_producer();
+    }
+
+public:
+    channel_producer(channel_producer const& rhs)
+        : state(rhs.state)
+    {
+        if (state) {
+            state->add_producer();
+        }
+    }
+
+    channel_producer(channel_producer&& rhs) noexcept = default;
+
+    auto operator=(channel_producer rhs) noexcept -> channel_producer& {
+        close();
+        state = std::move(rhs.state);
+        return *this;
+    }
+
+    ~channel_producer() {
+        close();
+    }
+
+    // pushes value, waiting for space if the queue is full. Returns false
+    // if it couldn't, because nobody is consuming any more
+    auto push(T value) -> bool {
+        return state and state->push(std::move(value), true);
+    }
+
+    // pushes value if there is space, without waiting. If it returns
+    // false, value hasn't been moved from
+    auto try_push(T&& value) -> bool {
+        return state and state->push(std::move(value), false);
+    }
+
+    auto try_push(T const& value) -> bool {
+        return state and state->push(value, false);
+    }
+
+    // this producer won't push any more. Once every producer has closed,
+    // and the queue has been drained, the channel ends
+    void close() {
+        if (state) {
+            state->remove_producer();
+            state.reset();
+        }
+    }
+};
+
+template <std::move_constructible T>
+class channel : public RiverBase<channel<T>>
+{
+    std::shared_ptr<detail::channel_state<T>> state;
+    // the part of the last batch claimed that hasn't been consumed yet
+    std::size_t first = 0;
+    std::size_t last = 0;
+
+    // gives back whatever hasn't been consumed
+    void release() {
+        state->put_back(first, last);
+        first = last = 0;
+    }
+
+public:
+    using reference = T;
+
+    explicit channel(std::size_t capacity = 1024)
+        : state(std::make_shared<detail::channel_state<T>>(capacity))
+    {
+        state->add_consumer();
+    }
+
+    channel(channel const& rhs)
+        : state(rhs.state)
+    {
+        if (state) {
+            state->add_consumer();
+        }
+    }
+
+    channel(channel&& rhs) noexcept
+        : state(std::move(rhs.state))
+        , first(std::exchange(rhs.first, 0))
+        , last(std::exchange(rhs.last, 0))
+    { }
+
+    auto operator=(channel rhs) noexcept -> channel& {
+        std::swap(state, rhs.state);
+        std::swap(first, rhs.first);
+        std::swap(last, rhs.last);
+        return *this;
+    }
+
+    ~channel() {
+        if (state) {
+            release();
+            state->remove_consumer();
+        }
+    }
+
+    // hands out a producer. Until the first one is, consuming the channel
+    // waits for one
+    auto producer() const -> channel_producer<T> {
+        channel_producer<T> p(state);
+        state->close();
+        return p;
+    }
+
+    // says that no producers will be handed out (any more), so that once
+    // those that were have closed, the channel ends
+    void close() const {
+        state->close();
+    }
+
+    auto while_(PredicateFor<reference> auto&& pred) -> bool {
+        for (;;) {
+            if (first == last and not state->claim(first, last)) {
+                first = last = 0;
+                if (auto leftover = state->take_leftover()) {
+                    if (not std::invoke(pred, std::move(*leftover))) {
+                        return false;
+                    }
+                    continue;
+                }
+                return true;
+            }
+
+            while (first != last) {
+                if (not std::invoke(pred, state->take(first++))) {
+                    state->freed();
+                    // if the rest can't be given back, they're consumed
+                    // by the next call instead
+                    if (first != last and state->unclaim(first, last)) {
+                        first = last = 0;
+                    }
+                    return false;
+                }
+            }
+            state->freed();
+        }
+    }
+};
+
+}
+
+#endif
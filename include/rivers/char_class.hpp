@@ -0,0 +1,99 @@
+#ifndef RIVERS_CHAR_CLASS_HPP
+#define RIVERS_CHAR_CLASS_HPP
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <string_view>
+
+namespace rvr {
+
+////////////////////////////////////////////////////////////////////////////
+// char_class: a set of bytes, as used by tokenize.
+// * char_class(" ,;")    the bytes in a string
+// * char_class(bits)     the bytes set in a std::bitset<256>
+// * char_class::space(), alnum(), and csv() for common classes
+// Classes can be combined with |, &, and ~.
+// Byte b is in the class if bit (b >> 4) & 7 of rows[(b >> 7) * 16 + (b & 15)]
+// is set. That is, for each low nibble, there's one byte of bits for the high
+// nibbles 0-7 and another for 8-15 - a layout that lets a whole vector of
+// bytes be classified with a few table lookups (see simd::find_in_class).
+////////////////////////////////////////////////////////////////////////////
+struct char_class {
+    std::array<std::uint8_t, 32> rows = {};
+
+    constexpr char_class() = default;
+
+    explicit constexpr char_class(std::string_view chars) {
+        for (char c : chars) {
+            insert(static_cast<unsigned char>(c));
+        }
+    }
+
+    explicit char_class(std::bitset<256> const& bits) {
+        for (unsigned b = 0; b != 256; ++b) {
+            if (bits[b]) {
+                insert(static_cast<unsigned char>(b));
+            }
+        }
+    }
+
+    constexpr auto insert(unsigned char b) -> char_class& {
+        rows[(b >> 7) * 16 + (b & 15)] |= std::uint8_t(1u << ((b >> 4) & 7));
+        return *this;
+    }
+
+    constexpr auto contains(unsigned char b) const -> bool {
+        return (rows[(b >> 7) * 16 + (b & 15)] >> ((b >> 4) & 7)) & 1;
+    }
+
+    friend constexpr auto operator|(char_class lhs, char_class const& rhs) -> char_class {
+        for (std::size_t i = 0; i != lhs.rows.size(); ++i) {
+            lhs.rows[i] |= rhs.rows[i];
+        }
+        return lhs;
+    }
+
+    friend constexpr auto operator&(char_class lhs, char_class const& rhs) -> char_class {
+        for (std::size_t i = 0; i != lhs.rows.size(); ++i) {
+            lhs.rows[i] &= rhs.rows[i];
+        }
+        return lhs;
+    }
+
+    friend constexpr auto operator~(char_class c) -> char_class {
+        for (std::uint8_t& row : c.rows) {
+            row = std::uint8_t(~row);
+        }
+        return c;
+    }
+
+    friend constexpr auto operator==(char_class const&, char_class const&) -> bool = default;
+
+    // ' ', '\t', '\n', '\v', '\f', and '\r' - as in std::isspace
+    static constexpr auto space() -> char_class {
+        return char_class(" \t\n\v\f\r");
+    }
+
+    // [0-9A-Za-z] - as in std::isalnum, in the C locale
+    static constexpr auto alnum() -> char_class {
+        char_class c;
+        for (unsigned char b = '0'; b <= '9'; ++b) {
+            c.insert(b);
+        }
+        for (unsigned char b = 'a'; b <= 'z'; ++b) {
+            c.insert(b);
+            c.insert(b - 'a' + 'A');
+        }
+        return c;
+    }
+
+    // the usual field separators: ',', '\t', ';', and '|'
+    static constexpr auto csv() -> char_class {
+        return char_class(",\t;|");
+    }
+};
+
+}
+
+#endif
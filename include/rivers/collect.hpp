@@ -8,18 +8,57 @@
 
 namespace rvr {
 
-template <typename T>
-struct collect_fn {
-    template <River R>
-        requires std::ranges::input_range<T>
-    friend constexpr auto tag_invoke(collect_fn<T>, R&& r) -> T {
-        T output;
-        r.for_each([&](auto&& elem){
-            output.push_back(RVR_FWD(elem));
-        });
-        return output;
-    }
+namespace detail {
+    // The default way to collect, which any river can override with a
+    // tag_invoke(collect_fn<T>, R) of its own. This one takes the base
+    // class, so that the conversion makes it a worse match than those.
+    template <typename T>
+    struct collect_default {
+        template <River R>
+            requires std::ranges::input_range<T>
+        friend constexpr auto tag_invoke(collect_default<T>, R&& r) -> T {
+            T output;
+            if constexpr (requires { output.reserve(std::size_t()); }) {
+                output.reserve(rvr::size_hint(r).lower);
+            }
 
+            // if the rest of the river sits in memory, it can be inserted
+            // all at once
+            if constexpr (ContiguousRiver<R>
+                      and std::same_as<std::ranges::range_value_t<T>, value_t<R>>
+                      and requires (std::span<std::remove_reference_t<reference_t<R>>> span) {
+                          output.insert(output.end(), span.begin(), span.end());
+                      })
+            {
+                auto const span = r.remaining();
+                output.insert(output.end(), span.begin(), span.end());
+                r.advance(span.size());
+            }
+            // for trivially copyable values, we can copy whole blocks at a
+            // time, which for vector ends up being a memcpy per block
+            else if constexpr (ChunkedRiver<R>
+                      and std::is_trivially_copyable_v<value_t<R>>
+                      and std::same_as<std::ranges::range_value_t<T>, value_t<R>>
+                      and requires (chunk_t<R> chunk) {
+                          output.insert(output.end(), chunk.begin(), chunk.end());
+                      })
+            {
+                r.while_chunk([&](chunk_t<R> chunk){
+                    output.insert(output.end(), chunk.begin(), chunk.end());
+                    return true;
+                });
+            } else {
+                r.for_each([&](auto&& elem){
+                    output.push_back(RVR_FWD(elem));
+                });
+            }
+            return output;
+        }
+    };
+}
+
+template <typename T>
+struct collect_fn : detail::collect_default<T> {
     template <River R>
         requires tag_invocable<collect_fn, R>
     constexpr auto operator()(R&& r) const {
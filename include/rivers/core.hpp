@@ -3,7 +3,10 @@
 
 #include <concepts>
 #include <ranges>
+#include <span>
+#include <stop_token>
 #include <rivers/optional.hpp>
+#include <rivers/simd.hpp>
 
 #define RVR_FWD(x) static_cast<decltype(x)&&>(x)
 #define RVR_RETURNS(e) -> decltype(e) { return e; }
@@ -88,6 +91,125 @@ concept ResettableRiver = River<R> && requires (R r) {
     };
 
 
+// A River is chunked if it has a member while_chunk(pred), which behaves
+// like while_ except that pred is handed contiguous blocks of values
+// (a chunk_t<R>) rather than one reference at a time. This lets terminals
+// run tight loops over whole blocks instead of going through a nested
+// predicate for every element.
+//
+// The rules for while_chunk are:
+// * every block has at least one and at most chunk_size elements
+// * if pred returns false, that entire block has been consumed
+// * a chunk holds values, so it should only be used where the elements
+//   are used as values (e.g. sum, but not a for_each that mutates them)
+//
+// Adapters that can't forward blocks simply don't provide while_chunk,
+// and everything falls back to while_.
+inline constexpr std::size_t chunk_size = 1024;
+
+template <typename R>
+using chunk_t = std::span<value_t<R> const>;
+
+template <typename R>
+concept ChunkedRiver = River<R> && requires (R r) {
+        { r.while_chunk(std::declval<bool(*)(chunk_t<R>)>()) } -> std::same_as<bool>;
+    };
+
+// A River can provide a member size_hint() giving bounds on the number of
+// elements remaining in it (not the number it started with). This is
+// purely an optimization - e.g. collect uses it to reserve - and must not
+// be relied on for correctness, except that an exact() hint must be exact.
+// Rivers that don't provide one are treated as unknown: [0, inf)
+struct SizeHint {
+    std::size_t lower = 0;
+    tl::optional<std::size_t> upper = tl::nullopt;
+
+    static constexpr auto exactly(std::size_t n) -> SizeHint {
+        return {.lower=n, .upper=n};
+    }
+
+    constexpr auto exact() const -> tl::optional<std::size_t> {
+        if (upper and *upper == lower) {
+            return lower;
+        } else {
+            return tl::nullopt;
+        }
+    }
+};
+
+struct {
+    template <River R>
+    constexpr auto operator()(R const& r) const -> SizeHint {
+        if constexpr (requires { { r.size_hint() } -> std::same_as<SizeHint>; }) {
+            return r.size_hint();
+        } else {
+            return {};
+        }
+    }
+} inline constexpr size_hint;
+
+// A River is splittable if it has a member try_split(), which splits off
+// roughly the first half of its remaining elements into a new river (like
+// Java's Spliterator::trySplit) and returns it as an optional. Afterwards,
+// this river only has the elements that weren't split off. If the river
+// can't be split, try_split() returns nullopt and leaves it unchanged.
+//
+// The split off river must itself be splittable, into rivers of its own
+// type, so that a river can be divided into any number of pieces.
+template <typename R>
+concept SplittableRiver = River<R> && requires (R r) {
+        { *r.try_split() } -> River;
+    };
+
+template <SplittableRiver R>
+using split_t = std::remove_cvref_t<decltype(*std::declval<R&>().try_split())>;
+
+namespace detail {
+    // stands in for the function passed to for_all
+    struct sink {
+        constexpr void operator()(auto&&) const { }
+    };
+}
+
+// A River can provide a member for_all(op), which invokes op on every one of
+// its remaining elements, leaving it empty. Unlike while_, there is no way to
+// stop early, so neither the river nor any adapter in between has to check
+// for that on every element. The terminal algorithms that always visit
+// every element (for_each, fold, sum, count, consume) use it when they can.
+template <typename R>
+concept ExhaustiveRiver = River<R> && requires (R r) {
+        r.for_all(detail::sink{});
+    };
+
+// A River can provide a member advance(n), which skips its next n elements
+// without visiting them (typically in constant time) and returns how many
+// elements were actually skipped - fewer than n only if the river ran out.
+template <typename R>
+concept AdvanceableRiver = River<R> && requires (R r, std::size_t n) {
+        { r.advance(n) } -> std::same_as<std::size_t>;
+    };
+
+// A River is contiguous if all of its remaining elements sit next to each
+// other in memory, and it has a member remaining() that returns them as a
+// span (without consuming anything). Together with advance(n), this lets an
+// adapter search ahead - say, with memchr - before deciding how much of the
+// river to consume.
+template <typename R>
+concept ContiguousRiver = AdvanceableRiver<R>
+    and std::is_lvalue_reference_v<reference_t<R>>
+    and requires (R r) {
+        { r.remaining() } -> std::same_as<std::span<std::remove_reference_t<reference_t<R>>>>;
+    };
+
+namespace detail {
+    // Adapters that produce their own blocks (rather than forwarding their
+    // base's) have to copy elements into a buffer, which we only do for
+    // simple numeric types
+    template <typename T>
+    concept bufferable = std::is_arithmetic_v<T>;
+}
+
+
 // simple scope guard implementation - since we're only ever capturing
 // by reference, construction can't throw, so can skip a lot of steps
 namespace detail {
@@ -113,6 +235,8 @@ namespace detail {
     auto RVR_UNIQUE_NAME(RVR_SCOPE_EXIT_GUARD) = \
     ::rvr::detail::scope_exit_tag{} + [&]() noexcept -> void
 
+struct char_class;
+
 template <typename Derived>
 struct RiverBase {
 private:
@@ -174,14 +298,38 @@ public:
         return not self().any(pred);
     }
 
+    // find(pred)
+    // * Returns: the first element for which pred is true, or nullopt if
+    //   there is none
+    template <typename Pred, typename D=Derived>
+        requires std::predicate<Pred&, reference_t<D>&>
+    constexpr auto find(Pred pred) -> tl::optional<value_t<D>>
+    {
+        tl::optional<value_t<D>> result;
+        self().while_([&](reference_t<D> elem){
+            if (std::invoke(pred, elem)) {
+                result.emplace(RVR_FWD(elem));
+                return false;
+            }
+            return true;
+        });
+        return result;
+    }
+
     // for_each(op)
     // Equivalent to (op(elem), ...);
     template <typename F> requires std::invocable<F&, reference_t<Derived>>
     constexpr void for_each(F&& f) {
-        self().while_([&](reference_t<Derived> e){
-            std::invoke(f, e);
-            return true;
-        });
+        if constexpr (ExhaustiveRiver<Derived>) {
+            self().for_all([&](reference_t<Derived> e){
+                std::invoke(f, e);
+            });
+        } else {
+            self().while_([&](reference_t<Derived> e){
+                std::invoke(f, e);
+                return true;
+            });
+        }
     }
 
     // next()
@@ -216,34 +364,84 @@ public:
         }
     constexpr auto fold(Z init, F op) -> Z
     {
-        for_each([&](reference_t<Derived> e){
-            init = op(std::move(init), RVR_FWD(e));
-        });
+        if constexpr (ChunkedRiver<Derived>
+                  and std::invocable<F&, Z, value_t<Derived> const&>) {
+            self().while_chunk([&](chunk_t<Derived> chunk){
+                // accumulate into a local, since init could otherwise
+                // alias the chunk and have to be stored on every element
+                Z acc = std::move(init);
+                for (auto const& e : chunk) {
+                    acc = op(std::move(acc), e);
+                }
+                init = std::move(acc);
+                return true;
+            });
+        } else {
+            for_each([&](reference_t<Derived> e){
+                init = op(std::move(init), RVR_FWD(e));
+            });
+        }
         return init;
     }
 
     // sum(init = value())
     // * Returns (init + ... + elems)
+    // For chunked rivers of integers, each block is summed with a vectorized
+    // kernel (see simd.hpp)
     template <typename D=Derived>
     constexpr auto sum(value_t<D> init = {}) -> value_t<D>
     {
+        if constexpr (ChunkedRiver<D> and detail::simd::reducible<value_t<D>>) {
+            if (not std::is_constant_evaluated()) {
+                self().while_chunk([&](chunk_t<D> chunk){
+                    init = init + detail::simd::sum(chunk);
+                    return true;
+                });
+                return init;
+            }
+        }
         return fold(RVR_FWD(init), std::plus());
     }
 
     // product(init = value(1))
     // * Returns (init * ... * elems)
+    // As with sum, chunked rivers of integers use a vectorized kernel
     template <typename D=Derived>
     constexpr auto product(value_t<D> init = value_t<D>(1)) -> value_t<D>
     {
+        if constexpr (ChunkedRiver<D> and detail::simd::reducible<value_t<D>>) {
+            if (not std::is_constant_evaluated()) {
+                self().while_chunk([&](chunk_t<D> chunk){
+                    init = init * detail::simd::product(chunk);
+                    return true;
+                });
+                return init;
+            }
+        }
         return fold(RVR_FWD(init), std::multiplies());
     }
 
     // count()
     // * Returns the number of elements in the river
+    // * If the river knows exactly how many elements it has left and can
+    //   skip them, doesn't visit any of them
     constexpr auto count() -> int
     {
+        if constexpr (AdvanceableRiver<Derived>) {
+            if (auto const n = rvr::size_hint(self()).exact()) {
+                return int(self().advance(*n));
+            }
+        }
+
         int i = 0;
-        for_each([&](auto&&){ ++i; });
+        if constexpr (ChunkedRiver<Derived>) {
+            self().while_chunk([&](chunk_t<Derived> chunk){
+                i += chunk.size();
+                return true;
+            });
+        } else {
+            for_each([&](auto&&){ ++i; });
+        }
         return i;
     }
 
@@ -288,9 +486,42 @@ public:
     constexpr auto drop(int n) &;
     constexpr auto drop(int n) &&;
 
-    // split(e): requires split.hpp
+    // split(e) and split(pattern): requires split.hpp
     template <typename D=Derived> constexpr auto split(value_t<D>) &;
     template <typename D=Derived> constexpr auto split(value_t<D>) &&;
+    template <typename D=Derived, std::ranges::contiguous_range P> constexpr auto split(P const&) &;
+    template <typename D=Derived, std::ranges::contiguous_range P> constexpr auto split(P const&) &&;
+
+    // split_views(e) and split_views(pattern): requires split.hpp
+    template <typename D=Derived> constexpr auto split_views(value_t<D>) &;
+    template <typename D=Derived> constexpr auto split_views(value_t<D>) &&;
+    template <typename D=Derived, std::ranges::contiguous_range P> constexpr auto split_views(P const&) &;
+    template <typename D=Derived, std::ranges::contiguous_range P> constexpr auto split_views(P const&) &&;
+
+    // tokenize(delims): requires split.hpp
+    template <typename D=Derived> constexpr auto tokenize(char_class const&) &;
+    template <typename D=Derived> constexpr auto tokenize(char_class const&) &&;
+
+    // async_buffer(n): requires async_buffer.hpp
+    auto async_buffer(std::size_t n = 1024) &;
+    auto async_buffer(std::size_t n = 1024) &&;
+
+    // par_map(f, workers, window) and par_map_unordered(f, workers, window):
+    // requires par_map.hpp
+    template <typename F> auto par_map(F&& f, std::size_t workers = 0, std::size_t window = 0) &;
+    template <typename F> auto par_map(F&& f, std::size_t workers = 0, std::size_t window = 0) &&;
+    template <typename F> auto par_map_unordered(F&& f, std::size_t workers = 0, std::size_t window = 0) &;
+    template <typename F> auto par_map_unordered(F&& f, std::size_t workers = 0, std::size_t window = 0) &&;
+
+    // until_stopped(token): requires stop.hpp
+    auto until_stopped(std::stop_token) &;
+    auto until_stopped(std::stop_token) &&;
+
+    // par() and par(exec): requires par.hpp
+    constexpr auto par() &;
+    constexpr auto par() &&;
+    template <typename E> constexpr auto par(E& exec) &;
+    template <typename E> constexpr auto par(E& exec) &&;
 };
 
 // and in non-member, callable form
@@ -302,6 +533,7 @@ public:
 RVR_ALGO_FUNCTION_OBJECT(all);
 RVR_ALGO_FUNCTION_OBJECT(any);
 RVR_ALGO_FUNCTION_OBJECT(none);
+RVR_ALGO_FUNCTION_OBJECT(find);
 RVR_ALGO_FUNCTION_OBJECT(for_each);
 RVR_ALGO_FUNCTION_OBJECT(next);
 RVR_ALGO_FUNCTION_OBJECT(next_ref);
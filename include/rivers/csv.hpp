@@ -0,0 +1,211 @@
+#ifndef RIVERS_CSV_HPP
+#define RIVERS_CSV_HPP
+
+#include <rivers/core.hpp>
+#include <rivers/from.hpp>
+#include <bit>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace rvr {
+
+////////////////////////////////////////////////////////////////////////////
+// csv: takes a contiguous river of chars (or a contiguous range of them) and
+// produces a river of its records, parsed as in RFC 4180:
+// * records end at '\n' (or "\r\n"), and fields are separated by
+//   options.separator (',' by default - '\t' for TSV)
+// * a field can be enclosed in options.quote ('"' by default), in which
+//   case it can contain separators, newlines, and doubled quotes
+// Each record is a CsvRow of CsvFields, which refer directly to the source,
+// so nothing is copied - quoted fields are only unescaped when asked for.
+// A CsvRow is only valid until the next record is read.
+// Records are found by classifying 64 bytes at a time into bitmasks of
+// quotes, separators, and newlines, and masking out whatever is between
+// quotes (see detail::simd::csv_masks).
+////////////////////////////////////////////////////////////////////////////
+
+struct CsvOptions {
+    char separator = ',';
+    char quote = '"';
+};
+
+class CsvField {
+    std::string_view text;
+    char quote = '\0';
+
+public:
+    constexpr CsvField() = default;
+    constexpr explicit CsvField(std::string_view text, char quote = '\0')
+        : text(text)
+        , quote(quote)
+    { }
+
+    // the field, without any enclosing quotes, but with the quotes inside
+    // it still doubled
+    constexpr auto raw() const -> std::string_view {
+        return text;
+    }
+
+    // whether raw() has doubled quotes in it, that str() collapses
+    constexpr auto escaped() const -> bool {
+        return quote != '\0';
+    }
+
+    // the field's value
+    auto str() const -> std::string {
+        std::string out;
+        append_to(out);
+        return out;
+    }
+
+    void append_to(std::string& out) const {
+        if (not escaped()) {
+            out.append(text);
+            return;
+        }
+        for (std::size_t i = 0; i != text.size(); ++i) {
+            out.push_back(text[i]);
+            i += (text[i] == quote and i + 1 != text.size() and text[i + 1] == quote);
+        }
+    }
+};
+
+class CsvRow {
+    std::span<CsvField const> fields;
+
+public:
+    constexpr CsvRow() = default;
+    constexpr explicit CsvRow(std::span<CsvField const> fields) : fields(fields) { }
+
+    constexpr auto size() const -> std::size_t { return fields.size(); }
+    constexpr auto operator[](std::size_t i) const -> CsvField const& { return fields[i]; }
+    constexpr auto begin() const { return fields.begin(); }
+    constexpr auto end() const { return fields.end(); }
+};
+
+template <ContiguousRiver R>
+    requires std::same_as<value_t<R>, char>
+struct Csv : RiverBase<Csv<R>>
+{
+private:
+    R base;
+    CsvOptions options;
+    std::vector<CsvField> fields;
+
+    // the field between first and last - the end of a record also drops a
+    // '\r' before the '\n'
+    void add_field(char const* first, char const* last, bool end_of_record) {
+        if (end_of_record and last != first and last[-1] == '\r') {
+            --last;
+        }
+
+        char const q = options.quote;
+        if (last - first >= 2 and first[0] == q and last[-1] == q) {
+            ++first;
+            --last;
+            bool const escaped = std::memchr(first, q, last - first) != nullptr;
+            fields.emplace_back(std::string_view(first, last - first), escaped ? q : '\0');
+        } else {
+            fields.emplace_back(std::string_view(first, last - first));
+        }
+    }
+
+    // reads the record at the start of rest into fields, returning how many
+    // chars it took up
+    auto read_record(std::span<char const> rest) -> std::size_t {
+        fields.clear();
+        char const* const p = rest.data();
+        std::size_t const n = rest.size();
+        std::size_t start = 0;
+
+        // all ones if the last block ended between quotes
+        std::uint64_t carry = 0;
+        for (std::size_t i = 0; i < n; i += 64) {
+            detail::simd::csv_block m;
+            if (n - i >= 64) {
+                m = detail::simd::csv_masks(p + i, options.separator, options.quote);
+            } else {
+                char tail[64] = {};
+                std::memcpy(tail, p + i, n - i);
+                m = detail::simd::csv_masks(tail, options.separator, options.quote);
+                std::uint64_t const valid = (std::uint64_t(1) << (n - i)) - 1;
+                m.quote &= valid;
+                m.separator &= valid;
+                m.newline &= valid;
+            }
+
+            std::uint64_t const quoted = detail::simd::prefix_xor(m.quote) ^ carry;
+            carry = std::uint64_t(std::int64_t(quoted) >> 63);
+
+            std::uint64_t ends = (m.separator | m.newline) & ~quoted;
+            while (ends != 0) {
+                auto const bit = std::countr_zero(ends);
+                std::size_t const k = i + bit;
+                if ((m.newline >> bit) & 1) {
+                    add_field(p + start, p + k, true);
+                    return k + 1;
+                }
+                add_field(p + start, p + k, false);
+                start = k + 1;
+                ends &= ends - 1;
+            }
+        }
+
+        // the last record doesn't have to end with a newline
+        add_field(p + start, p + n, true);
+        return n;
+    }
+
+public:
+    using reference = CsvRow;
+
+    Csv(R base, CsvOptions options)
+        : base(std::move(base))
+        , options(options)
+    { }
+
+    auto while_(PredicateFor<reference> auto&& pred) -> bool {
+        for (;;) {
+            auto const rest = std::span<char const>(base.remaining());
+            if (rest.empty()) {
+                return true;
+            }
+            base.advance(read_record(rest));
+            if (not std::invoke(pred, CsvRow(fields))) {
+                return false;
+            }
+        }
+    }
+
+    // every record but the last takes up at least one char for its '\n'
+    auto size_hint() const -> SizeHint {
+        auto const n = base.remaining().size();
+        return {.lower=(n > 0), .upper=n};
+    }
+
+    void reset() requires ResettableRiver<R> {
+        base.reset();
+    }
+};
+
+struct {
+    template <River R>
+        requires ContiguousRiver<std::remove_cvref_t<R>>
+    auto operator()(R&& r, CsvOptions options = {}) const {
+        return Csv<std::remove_cvref_t<R>>(RVR_FWD(r), options);
+    }
+
+    // the fields point into the buffer, so it has to outlive the river
+    template <std::ranges::contiguous_range B>
+        requires std::ranges::borrowed_range<B> and (not River<B>)
+    auto operator()(B&& buffer, CsvOptions options = {}) const {
+        return (*this)(rvr::from(RVR_FWD(buffer)), options);
+    }
+} inline constexpr csv;
+
+}
+
+#endif
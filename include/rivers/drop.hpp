@@ -1,6 +1,8 @@
 #ifndef RIVERS_DROP_HPP
 #define RIVERS_DROP_HPP
 
+#include <algorithm>
+#include <utility>
 #include <rivers/core.hpp>
 
 namespace rvr {
@@ -17,27 +19,91 @@ struct Drop : RiverBase<Drop<R>>
 private:
     R base;
     int n;
-    int i = 0;
+    int to_skip = n;
+
+    // Skips whatever is left to skip, returning false if that exhausted base
+    constexpr auto skip() -> bool {
+        if (to_skip == 0) {
+            return true;
+        }
+
+        if constexpr (AdvanceableRiver<R>) {
+            base.advance(std::exchange(to_skip, 0));
+            return true;
+        } else {
+            return not base.while_([&](reference_t<R>){
+                return --to_skip != 0;
+            });
+        }
+    }
 
 public:
     using reference = reference_t<R>;
 
-    constexpr Drop(R base, int n) : base(std::move(base)), n(n) { }
+    constexpr Drop(R base, int n) : base(std::move(base)), n(std::max(n, 0)) { }
 
     constexpr auto while_(PredicateFor<reference> auto&& pred) -> bool {
-        return base.while_([&](reference elem){
-            if (i++ < n) {
-                return true;
-            } else {
-                return std::invoke(pred, elem);
+        return not skip() or base.while_(RVR_FWD(pred));
+    }
+
+    constexpr void for_all(std::invocable<reference> auto&& op)
+        requires ExhaustiveRiver<R>
+    {
+        if (skip()) {
+            base.for_all(RVR_FWD(op));
+        }
+    }
+
+    constexpr auto while_chunk(PredicateFor<chunk_t<Drop>> auto&& pred) -> bool
+        requires ChunkedRiver<R>
+    {
+        if constexpr (not AdvanceableRiver<R>) {
+            // skip within blocks, rather than one element at a time
+            if (to_skip != 0) {
+                return base.while_chunk([&](chunk_t<R> chunk){
+                    if (to_skip != 0) {
+                        auto const k = std::min<std::size_t>(chunk.size(), to_skip);
+                        to_skip -= int(k);
+                        chunk = chunk.subspan(k);
+                        if (chunk.empty()) {
+                            return true;
+                        }
+                    }
+                    return std::invoke(pred, chunk);
+                });
             }
-        });
+        }
+
+        return not skip() or base.while_chunk(RVR_FWD(pred));
+    }
+
+    constexpr auto size_hint() const -> SizeHint {
+        auto const minus_skip = [skip=std::size_t(to_skip)](std::size_t k){
+            return k > skip ? k - skip : 0;
+        };
+
+        auto const hint = rvr::size_hint(base);
+        return {.lower=minus_skip(hint.lower),
+                .upper=hint.upper.map(minus_skip)};
+    }
+
+    constexpr auto advance(std::size_t k) -> std::size_t
+        requires AdvanceableRiver<R>
+    {
+        skip();
+        return base.advance(k);
+    }
+
+    // doesn't skip anything yet, so that it can stay const
+    constexpr auto remaining() const requires ContiguousRiver<R> {
+        auto const all = base.remaining();
+        return all.subspan(std::min<std::size_t>(all.size(), to_skip));
     }
 
     void reset() requires ResettableRiver<R>
     {
         base.reset();
-        i = 0;
+        to_skip = n;
     }
 };
 
@@ -55,7 +121,7 @@ constexpr auto RiverBase<Derived>::drop(int n) & {
 
 template <typename Derived>
 constexpr auto RiverBase<Derived>::drop(int n) && {
-    return Drop(RVR_FWD(self()), n);
+    return Drop(std::move(self()), n);
 }
 
 }
@@ -32,6 +32,58 @@ public:
         });
     }
 
+    constexpr void for_all(std::invocable<reference> auto&& op)
+        requires ExhaustiveRiver<R>
+    {
+        base.for_all([&](reference e){
+            if (std::invoke(filter, e)) {
+                std::invoke(op, RVR_FWD(e));
+            }
+        });
+    }
+
+    // if our base is chunked, we evaluate our predicate on a whole block,
+    // and then compact the elements that satisfy it into a local buffer
+    // without branching on each one (see simd::compress)
+    constexpr auto while_chunk(PredicateFor<chunk_t<Filter>> auto&& pred) -> bool
+        requires ChunkedRiver<R>
+             and detail::bufferable<value_t<Filter>>
+             and std::predicate<P&, value_t<R> const&>
+    {
+        return base.while_chunk([&](chunk_t<R> chunk){
+            // full blocks get a loop with a constant trip count, which
+            // compilers are much more willing to vectorize
+            bool keep[chunk_size];
+            auto const evaluate = [&](std::size_t n){
+                for (std::size_t i = 0; i != n; ++i) {
+                    keep[i] = std::invoke(filter, chunk[i]);
+                }
+            };
+            if (chunk.size() == chunk_size) {
+                evaluate(chunk_size);
+            } else {
+                evaluate(chunk.size());
+            }
+
+            value_t<Filter> buffer[chunk_size + detail::simd::compress_slack];
+            std::size_t const n = detail::simd::compress(
+                chunk.data(), keep, chunk.size(), buffer);
+            return n == 0 or std::invoke(pred, chunk_t<Filter>(buffer, n));
+        });
+    }
+
+    constexpr auto size_hint() const -> SizeHint {
+        return {.upper=rvr::size_hint(base).upper};
+    }
+
+    constexpr auto try_split() requires SplittableRiver<R>
+                                    and std::copy_constructible<P>
+    {
+        return base.try_split().map([&](split_t<R>&& prefix){
+            return Filter<split_t<R>, P>(std::move(prefix), filter);
+        });
+    }
+
     void reset() requires ResettableRiver<R> {
         base.reset();
     }
@@ -56,7 +108,7 @@ template <typename Derived>
 template <typename P>
 constexpr auto RiverBase<Derived>::filter(P&& pred) && {
     static_assert(std::predicate<P&, reference_t<Derived>&>);
-    return Filter(RVR_FWD(self()), RVR_FWD(pred));
+    return Filter(std::move(self()), RVR_FWD(pred));
 }
 
 }
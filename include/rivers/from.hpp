@@ -1,6 +1,7 @@
 #ifndef RIVERS_FROM_HPP
 #define RIVERS_FROM_HPP
 
+#include <algorithm>
 #include <ranges>
 #include <rivers/core.hpp>
 #include <rivers/tag_invoke.hpp>
@@ -12,7 +13,8 @@ namespace rvr {
 // Converting a C++ Range to a River
 // * from(r)           for a range
 // * from(first, last) for an iterator/sentinel pair
-// The resulting river is resettable if the source range is forward or better
+// The resulting river is resettable if the source range is forward or better,
+// and chunked and contiguous if the source range is contiguous
 ////////////////////////////////////////////////////////////////////////////
 template <std::ranges::input_range R>
 struct From : RiverBase<From<R>>
@@ -38,6 +40,73 @@ public:
         return true;
     }
 
+    constexpr void for_all(std::invocable<reference> auto&& op) {
+        for (; it != end; ++it) {
+            std::invoke(op, *it);
+        }
+    }
+
+    constexpr auto while_chunk(PredicateFor<chunk_t<From>> auto&& pred) -> bool
+        requires std::ranges::contiguous_range<R>
+             and std::sized_sentinel_for<std::ranges::sentinel_t<R>,
+                                         std::ranges::iterator_t<R>>
+    {
+        while (it != end) {
+            auto const n = std::min<std::size_t>(end - it, chunk_size);
+            auto const chunk = chunk_t<From>(std::to_address(it), n);
+            it += n;
+            if (not std::invoke(pred, chunk)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    constexpr auto size_hint() const -> SizeHint
+        requires std::sized_sentinel_for<std::ranges::sentinel_t<R>,
+                                         std::ranges::iterator_t<R>>
+    {
+        return SizeHint::exactly(end - it);
+    }
+
+    constexpr auto advance(std::size_t n) -> std::size_t
+        requires std::ranges::random_access_range<R>
+             and std::sized_sentinel_for<std::ranges::sentinel_t<R>,
+                                         std::ranges::iterator_t<R>>
+    {
+        auto const k = std::min<std::size_t>(n, end - it);
+        it += k;
+        return k;
+    }
+
+    constexpr auto remaining() const
+        requires std::ranges::contiguous_range<R>
+             and std::sized_sentinel_for<std::ranges::sentinel_t<R>,
+                                         std::ranges::iterator_t<R>>
+    {
+        return std::span<std::remove_reference_t<reference>>(std::to_address(it), end - it);
+    }
+
+    // try_split() splits off the first half of the remaining elements, as a
+    // river over a subrange of our range
+    constexpr auto try_split()
+        requires std::ranges::random_access_range<R>
+             and std::sized_sentinel_for<std::ranges::sentinel_t<R>,
+                                         std::ranges::iterator_t<R>>
+    {
+        using Prefix = From<std::ranges::subrange<std::ranges::iterator_t<R>>>;
+
+        auto const n = end - it;
+        if (n < 2) {
+            return tl::optional<Prefix>();
+        }
+
+        auto const mid = it + n / 2;
+        auto prefix = tl::optional<Prefix>(std::ranges::subrange(it, mid));
+        it = mid;
+        return prefix;
+    }
+
     void reset() requires std::ranges::forward_range<R> {
         it = std::ranges::begin(base);
     }
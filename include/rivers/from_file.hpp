@@ -0,0 +1,323 @@
+#ifndef RIVERS_FROM_FILE_HPP
+#define RIVERS_FROM_FILE_HPP
+
+#if __has_include(<sys/mman.h>)
+#include <rivers/core.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace rvr {
+
+////////////////////////////////////////////////////////////////////////////
+// Rivers over memory-mapped files
+// * from_file<T>(path) is a river of the file's contents as T's (char,
+//   unsigned char, or std::byte), and from_file_bytes(path) is
+//   from_file<std::byte>(path)
+// * from_file_lines(path) is a river of std::string_view's of the lines in
+//   the file, excluding the '\n's, pointing into the mapping
+// * from_records<T>(path) is a river of T const&'s straight out of the
+//   mapping, for a file that is a flat array of trivially copyable T's (as
+//   written by write_records). A std::runtime_error is thrown if the file's
+//   size isn't a multiple of sizeof(T), or the mapping isn't aligned for T.
+// The whole file is mapped read-only, and the kernel is advised that it will
+// be read sequentially. Passing {.populate=true} asks for the whole file to
+// be read in up front (MAP_POPULATE), where supported.
+// These rivers share ownership of the mapping, so they (and the pieces they
+// split into) can be copied and outlive each other freely - but the
+// string_views don't keep the mapping alive. Resetting them is free.
+////////////////////////////////////////////////////////////////////////////
+
+struct MapOptions {
+    bool populate = false;
+};
+
+namespace detail {
+    class mapped_file {
+        void* data = nullptr;
+        std::size_t size = 0;
+
+    public:
+        explicit mapped_file(std::filesystem::path const& path, MapOptions options) {
+            int const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                throw std::system_error(errno, std::generic_category(),
+                                        "rivers: could not open " + path.string());
+            }
+
+            struct stat st;
+            if (::fstat(fd, &st) != 0) {
+                int const error = errno;
+                ::close(fd);
+                throw std::system_error(error, std::generic_category(),
+                                        "rivers: could not stat " + path.string());
+            }
+
+            // mapping nothing is an error, so empty files just stay unmapped
+            if (st.st_size > 0) {
+                int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+                if (options.populate) {
+                    flags |= MAP_POPULATE;
+                }
+#endif
+                void* const p = ::mmap(nullptr, std::size_t(st.st_size), PROT_READ, flags, fd, 0);
+                if (p == MAP_FAILED) {
+                    int const error = errno;
+                    ::close(fd);
+                    throw std::system_error(error, std::generic_category(),
+                                            "rivers: could not map " + path.string());
+                }
+                data = p;
+                size = std::size_t(st.st_size);
+                ::madvise(data, size, MADV_SEQUENTIAL);
+            }
+            ::close(fd);
+        }
+
+        mapped_file(mapped_file const&) = delete;
+        auto operator=(mapped_file const&) -> mapped_file& = delete;
+
+        ~mapped_file() {
+            if (data) {
+                ::munmap(data, size);
+            }
+        }
+
+        template <typename T>
+        auto contents() const -> std::span<T const> {
+            return {static_cast<T const*>(data), size / sizeof(T)};
+        }
+    };
+
+    inline auto map_file(std::filesystem::path const& path, MapOptions options)
+        -> std::shared_ptr<mapped_file const>
+    {
+        return std::make_shared<mapped_file const>(path, options);
+    }
+
+    template <typename T>
+    concept file_byte = std::same_as<T, char>
+                     or std::same_as<T, unsigned char>
+                     or std::same_as<T, std::byte>;
+
+    template <typename T>
+    concept file_record = std::is_object_v<T> and std::is_trivially_copyable_v<T>;
+}
+
+template <detail::file_record T>
+struct FromFile : RiverBase<FromFile<T>>
+{
+private:
+    std::shared_ptr<detail::mapped_file const> file;
+    T const* first;
+    T const* it;
+    T const* last;
+
+    FromFile(std::shared_ptr<detail::mapped_file const> file, std::span<T const> contents)
+        : file(std::move(file))
+        , first(contents.data())
+        , it(first)
+        , last(first + contents.size())
+    { }
+
+public:
+    using reference = T const&;
+    using value_type = T;
+
+    explicit FromFile(std::shared_ptr<detail::mapped_file const> f)
+        : FromFile(f, f->template contents<T>())
+    { }
+
+    auto while_(PredicateFor<reference> auto&& pred) -> bool {
+        while (it != last) {
+            RVR_SCOPE_EXIT { ++it; };
+            if (not std::invoke(pred, *it)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void for_all(std::invocable<reference> auto&& op) {
+        for (; it != last; ++it) {
+            std::invoke(op, *it);
+        }
+    }
+
+    auto while_chunk(PredicateFor<chunk_t<FromFile>> auto&& pred) -> bool {
+        while (it != last) {
+            auto const n = std::min<std::size_t>(last - it, chunk_size);
+            auto const chunk = chunk_t<FromFile>(it, n);
+            it += n;
+            if (not std::invoke(pred, chunk)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    auto size_hint() const -> SizeHint {
+        return SizeHint::exactly(last - it);
+    }
+
+    auto advance(std::size_t n) -> std::size_t {
+        auto const k = std::min<std::size_t>(n, last - it);
+        it += k;
+        return k;
+    }
+
+    auto remaining() const -> std::span<T const> {
+        return {it, last};
+    }
+
+    auto try_split() -> tl::optional<FromFile> {
+        auto const n = last - it;
+        if (n < 2) {
+            return tl::nullopt;
+        }
+
+        T const* const mid = it + n / 2;
+        auto prefix = FromFile(file, std::span(it, mid));
+        it = mid;
+        first = mid;
+        return prefix;
+    }
+
+    void reset() {
+        it = first;
+    }
+};
+
+struct FromFileLines : RiverBase<FromFileLines>
+{
+private:
+    std::shared_ptr<detail::mapped_file const> file;
+    char const* first;
+    char const* it;
+    char const* last;
+
+    FromFileLines(std::shared_ptr<detail::mapped_file const> file, std::span<char const> contents)
+        : file(std::move(file))
+        , first(contents.data())
+        , it(first)
+        , last(first + contents.size())
+    { }
+
+    // the line starting at it, moving it past the line's '\n'
+    auto next_line() -> std::string_view {
+        auto const nl = static_cast<char const*>(std::memchr(it, '\n', last - it));
+        char const* const end = nl ? nl : last;
+        std::string_view const line(it, end - it);
+        it = nl ? nl + 1 : last;
+        return line;
+    }
+
+public:
+    using reference = std::string_view;
+
+    explicit FromFileLines(std::shared_ptr<detail::mapped_file const> f)
+        : FromFileLines(f, f->contents<char>())
+    { }
+
+    auto while_(PredicateFor<reference> auto&& pred) -> bool {
+        while (it != last) {
+            if (not std::invoke(pred, next_line())) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void for_all(std::invocable<reference> auto&& op) {
+        while (it != last) {
+            std::invoke(op, next_line());
+        }
+    }
+
+    // every line takes up at least one character
+    auto size_hint() const -> SizeHint {
+        auto const n = std::size_t(last - it);
+        return {.lower=(n > 0), .upper=n};
+    }
+
+    // splits at the first line that starts in the second half
+    auto try_split() -> tl::optional<FromFileLines> {
+        auto const n = last - it;
+        if (n < 2) {
+            return tl::nullopt;
+        }
+
+        char const* const half = it + n / 2;
+        auto const nl = static_cast<char const*>(std::memchr(half, '\n', last - half));
+        if (not nl or nl + 1 == last) {
+            return tl::nullopt;
+        }
+
+        auto prefix = FromFileLines(file, std::span(it, nl + 1));
+        it = nl + 1;
+        first = nl + 1;
+        return prefix;
+    }
+
+    void reset() {
+        it = first;
+    }
+};
+
+template <detail::file_byte T>
+struct from_file_fn {
+    auto operator()(std::filesystem::path const& path, MapOptions options = {}) const {
+        return FromFile<T>(detail::map_file(path, options));
+    }
+};
+
+template <detail::file_byte T>
+inline constexpr from_file_fn<T> from_file;
+
+inline constexpr from_file_fn<std::byte> from_file_bytes;
+
+template <detail::file_record T>
+struct from_records_fn {
+    auto operator()(std::filesystem::path const& path, MapOptions options = {}) const {
+        auto file = detail::map_file(path, options);
+        auto const bytes = file->contents<std::byte>();
+        if (bytes.size() % sizeof(T) != 0) {
+            throw std::runtime_error("rivers: the size of " + path.string()
+                                     + " isn't a multiple of the record size");
+        }
+        if (reinterpret_cast<std::uintptr_t>(bytes.data()) % alignof(T) != 0) {
+            throw std::runtime_error("rivers: the mapping of " + path.string()
+                                     + " isn't aligned for the record type");
+        }
+        return FromFile<T>(std::move(file));
+    }
+};
+
+template <detail::file_record T>
+inline constexpr from_records_fn<T> from_records;
+
+struct {
+    auto operator()(std::filesystem::path const& path, MapOptions options = {}) const {
+        return FromFileLines(detail::map_file(path, options));
+    }
+} inline constexpr from_file_lines;
+
+}
+
+#endif
+
+#endif
@@ -26,6 +26,50 @@ public:
         });
     }
 
+    constexpr void for_all(std::invocable<reference> auto&& op)
+        requires ExhaustiveRiver<R>
+    {
+        base.for_all([&](reference_t<R> e){
+            std::invoke(op, std::invoke(f, RVR_FWD(e)));
+        });
+    }
+
+    // if our base is chunked and we're producing plain numbers, we can map
+    // a whole block at a time into a local buffer
+    constexpr auto while_chunk(PredicateFor<chunk_t<Map>> auto&& pred) -> bool
+        requires ChunkedRiver<R>
+             and std::same_as<reference, value_t<Map>>
+             and detail::bufferable<reference>
+             and std::regular_invocable<F&, value_t<R> const&>
+    {
+        return base.while_chunk([&](chunk_t<R> chunk){
+            value_t<Map> buffer[chunk_size];
+            for (std::size_t i = 0; i != chunk.size(); ++i) {
+                buffer[i] = std::invoke(f, chunk[i]);
+            }
+            return std::invoke(pred, chunk_t<Map>(buffer, chunk.size()));
+        });
+    }
+
+    constexpr auto size_hint() const -> SizeHint {
+        return rvr::size_hint(base);
+    }
+
+    // skipped elements are never passed to f
+    constexpr auto advance(std::size_t n) -> std::size_t
+        requires AdvanceableRiver<R>
+    {
+        return base.advance(n);
+    }
+
+    constexpr auto try_split() requires SplittableRiver<R>
+                                    and std::copy_constructible<F>
+    {
+        return base.try_split().map([&](split_t<R>&& prefix){
+            return Map<split_t<R>, F>(std::move(prefix), f);
+        });
+    }
+
     void reset() requires ResettableRiver<R> {
         base.reset();
     }
@@ -50,7 +94,7 @@ template <typename Derived>
 template <typename F>
 constexpr auto RiverBase<Derived>::map(F&& f) && {
     static_assert(std::invocable<F&, reference_t<Derived>>);
-    return Map(RVR_FWD(self()), RVR_FWD(f));
+    return Map(std::move(self()), RVR_FWD(f));
 }
 
 }
@@ -3,6 +3,7 @@
 
 #include <rivers/core.hpp>
 #include <rivers/from.hpp>
+#include <utility>
 
 ////////////////////////////////////////////////////////////////////////////
 // Convert specifically provided values to a River
@@ -35,6 +36,16 @@ public:
         }
     }
 
+    constexpr void for_all(std::invocable<reference> auto&& op) {
+        if (not std::exchange(consumed, true)) {
+            std::invoke(op, value);
+        }
+    }
+
+    constexpr auto size_hint() const -> SizeHint {
+        return SizeHint::exactly(consumed ? 0 : 1);
+    }
+
     void reset() {
         consumed = false;
     }
@@ -0,0 +1,524 @@
+#ifndef RIVERS_PAR_HPP
+#define RIVERS_PAR_HPP
+
+#include <rivers/core.hpp>
+#include <rivers/collect.hpp>
+#include <rivers/filter.hpp>
+#include <rivers/map.hpp>
+#include <rivers/ref.hpp>
+#include <rivers/stop.hpp>
+#include <rivers/thread_pool.hpp>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace rvr {
+
+////////////////////////////////////////////////////////////////////////////
+// par: takes a SplittableRiver and produces a river whose terminal
+// algorithms run in parallel. The river is split into pieces (see
+// try_split), the pieces are consumed as tasks on an executor (by default,
+// the global thread_pool), and the partial results are then combined in
+// order. The river is split into a few more pieces than the executor has
+// threads, so that work stealing can even out pieces of unequal cost.
+// * map and filter on a parallel river produce a parallel river, so that
+//   they run on each of the pieces
+// * sum, product, count, all, any, none, find, fold(init, op, combine),
+//   and collecting into a vector (e.g. into_vec) run in parallel.
+//   Everything else is sequential.
+// * all, any, none, find, and take(n) stop the other pieces once the
+//   answer is known, checking between batches of elements (counting the
+//   ones that map and filter drop)
+// * until_stopped(token) on a parallel river stays parallel
+////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+    // Recursively halves r, depth times, appending the pieces that are split
+    // off to out in order. Whatever is left over stays in r.
+    template <SplittableRiver R, typename S>
+    void split_into(R& r, int depth, std::vector<S>& out) {
+        if (depth == 0) {
+            return;
+        }
+
+        if (auto prefix = r.try_split()) {
+            S piece = std::move(*prefix);
+            split_into(piece, depth - 1, out);
+            out.push_back(std::move(piece));
+            split_into(r, depth - 1, out);
+        }
+    }
+
+    // Like r.while_(pred), except that it returns false as soon as stopped()
+    // is true, which is checked every chunk_size elements of the river
+    // underneath r's adapters - so elements that a filter drops count too.
+    // r is split into batches that size (if it can be), which are consumed
+    // in order, so whatever is left of a batch when pred returns false is
+    // lost: this is only for consuming r entirely. Returns whether it got
+    // all the way through.
+    template <River S, typename Stopped, typename P>
+    auto while_batches(S& r, Stopped& stopped, P& pred) -> bool {
+        if (stopped()) {
+            return false;
+        }
+
+        if constexpr (SplittableRiver<S> and std::convertible_to<split_t<S>, S>) {
+            auto const upper = rvr::size_hint(r).upper;
+            if (upper and *upper > chunk_size) {
+                if (auto prefix = r.try_split()) {
+                    S batch = std::move(*prefix);
+                    return while_batches(batch, stopped, pred)
+                       and while_batches(r, stopped, pred);
+                }
+            }
+        }
+
+        // too small to split (or unknown), so check between the elements
+        // that get through instead
+        bool through = true;
+        UntilStopped(r.ref(), std::ref(stopped)).while_([&](auto&& elem){
+            return through = std::invoke(pred, RVR_FWD(elem));
+        });
+        return through and not stopped();
+    }
+}
+
+template <SplittableRiver R, executor E>
+struct ParTake;
+
+template <SplittableRiver R, executor E>
+struct Par : RiverBase<Par<R, E>>
+{
+private:
+    R base;
+    E* exec;
+
+    // Splits our base into pieces, in order. The last piece is whatever
+    // remains of base itself.
+    auto split() -> std::vector<split_t<R>> {
+        std::size_t const threads = exec->concurrency();
+        std::vector<split_t<R>> pieces;
+        if (threads > 1) {
+            detail::split_into(base, std::bit_width(threads - 1) + 2, pieces);
+        }
+        return pieces;
+    }
+
+    // Invokes f on every piece (and on base, as the last piece) as a task on
+    // our executor - the last on the calling thread. If f takes the index
+    // of the piece too, it's given that. Returns the results in order.
+    template <typename F>
+    auto run_on(std::vector<split_t<R>>& pieces, F f) {
+        auto call = [&](auto& piece, std::size_t i){
+            if constexpr (std::invocable<F&, decltype(piece), std::size_t>) {
+                return f(piece, i);
+            } else {
+                return f(piece);
+            }
+        };
+
+        using T = decltype(call(base, 0));
+        std::vector<tl::optional<T>> results(pieces.size() + 1);
+        std::vector<std::exception_ptr> errors(pieces.size() + 1);
+        auto run_one = [&](std::size_t i){
+            try {
+                if (i == pieces.size()) {
+                    results[i].emplace(call(base, i));
+                } else {
+                    results[i].emplace(call(pieces[i], i));
+                }
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        };
+        detail::fork_join(*exec, pieces.size() + 1, run_one);
+
+        for (std::exception_ptr const& e : errors) {
+            if (e) {
+                std::rethrow_exception(e);
+            }
+        }
+        return results;
+    }
+
+    template <typename F>
+    auto run(F f) {
+        auto pieces = split();
+        return run_on(pieces, std::move(f));
+    }
+
+    // Every piece is collected into a buffer of its own. A prefix sum of
+    // their sizes gives each buffer its place in the result, which is
+    // sized once, and then the buffers are all moved into place (and
+    // freed) in parallel - or appended one after another, if they can't
+    // be. This keeps the order of the elements.
+    template <typename V>
+    auto collect_vector() -> V
+    {
+        auto partials = run([](auto& piece){ return rvr::collect<V>(piece); });
+        if (partials.size() == 1) {
+            return std::move(*partials.front());
+        }
+
+        std::vector<std::size_t> offsets(partials.size() + 1);
+        for (std::size_t i = 0; i != partials.size(); ++i) {
+            offsets[i + 1] = offsets[i] + partials[i]->size();
+        }
+
+        using T = typename V::value_type;
+        V result;
+        // only into real storage: vector<bool> packs its elements, so
+        // placing them in parallel would have threads share words
+        if constexpr (std::ranges::contiguous_range<V>
+                  and std::default_initializable<T>
+                  and std::is_nothrow_move_assignable_v<T>) {
+            result.resize(offsets.back());
+            auto place = [&](std::size_t i){
+                std::ranges::move(*partials[i], result.begin() + offsets[i]);
+                partials[i].reset();
+            };
+            detail::fork_join(*exec, partials.size(), place);
+        } else {
+            result.reserve(offsets.back());
+            for (auto& partial : partials) {
+                result.insert(result.end(),
+                              std::make_move_iterator(partial->begin()),
+                              std::make_move_iterator(partial->end()));
+            }
+        }
+        return result;
+    }
+
+public:
+    using reference = reference_t<R>;
+
+    constexpr Par(R base, E& exec)
+        : base(std::move(base))
+        , exec(&exec)
+    { }
+
+    constexpr auto while_(PredicateFor<reference> auto&& pred) -> bool {
+        return base.while_(RVR_FWD(pred));
+    }
+
+    constexpr void for_all(std::invocable<reference> auto&& op)
+        requires ExhaustiveRiver<R>
+    {
+        base.for_all(RVR_FWD(op));
+    }
+
+    constexpr auto while_chunk(PredicateFor<chunk_t<Par>> auto&& pred) -> bool
+        requires ChunkedRiver<R>
+    {
+        return base.while_chunk(RVR_FWD(pred));
+    }
+
+    constexpr auto size_hint() const -> SizeHint {
+        return rvr::size_hint(base);
+    }
+
+    void reset() requires ResettableRiver<R> {
+        base.reset();
+    }
+
+    ///////////////////////////////////////////////////////////////////
+    // adapters that stay parallel
+    ///////////////////////////////////////////////////////////////////
+    template <typename F>
+    auto map(F&& f) & {
+        return rvr::Par(Map(base, RVR_FWD(f)), *exec);
+    }
+
+    template <typename F>
+    auto map(F&& f) && {
+        return rvr::Par(Map(std::move(base), RVR_FWD(f)), *exec);
+    }
+
+    template <typename P = std::identity>
+    auto filter(P&& pred = {}) & {
+        return rvr::Par(Filter(base, RVR_FWD(pred)), *exec);
+    }
+
+    template <typename P = std::identity>
+    auto filter(P&& pred = {}) && {
+        return rvr::Par(Filter(std::move(base), RVR_FWD(pred)), *exec);
+    }
+
+    auto until_stopped(stop_token token) & {
+        return rvr::Par(UntilStopped(base, detail::token_stopped{std::move(token)}), *exec);
+    }
+
+    auto until_stopped(stop_token token) && {
+        return rvr::Par(UntilStopped(std::move(base), detail::token_stopped{std::move(token)}), *exec);
+    }
+
+    // take(n) isn't parallel itself (see ParTake), but finds its elements
+    // in parallel
+    auto take(int n) & {
+        return ParTake<R, E>(*this, n);
+    }
+
+    auto take(int n) && {
+        return ParTake<R, E>(std::move(*this), n);
+    }
+
+private:
+    template <SplittableRiver, executor> friend struct ParTake;
+
+    // The first n elements, in order. Every piece collects up to n elements,
+    // and stops once the pieces before it have found n between them.
+    auto first(std::size_t n) -> std::vector<value_t<Par>>
+    {
+        auto pieces = split();
+        std::unique_ptr<std::atomic<std::size_t>[]> found(new std::atomic<std::size_t>[pieces.size() + 1]);
+        for (std::size_t i = 0; i != pieces.size() + 1; ++i) {
+            found[i].store(0, std::memory_order_relaxed);
+        }
+
+        auto partials = run_on(pieces, [&](auto& piece, std::size_t i){
+            auto enough_before = [&]{
+                std::size_t total = 0;
+                for (std::size_t j = 0; j != i; ++j) {
+                    total += found[j].load(std::memory_order_relaxed);
+                }
+                return total >= n;
+            };
+
+            std::vector<value_t<Par>> out;
+            auto keep = [&](auto&& elem){
+                out.push_back(RVR_FWD(elem));
+                found[i].store(out.size(), std::memory_order_relaxed);
+                return out.size() != n;
+            };
+            if (n != 0) {
+                detail::while_batches(piece, enough_before, keep);
+            }
+            return out;
+        });
+
+        std::vector<value_t<Par>> result;
+        for (auto& partial : partials) {
+            std::size_t const m = std::min(partial->size(), n - result.size());
+            result.insert(result.end(),
+                          std::make_move_iterator(partial->begin()),
+                          std::make_move_iterator(partial->begin() + m));
+            if (result.size() == n) {
+                break;
+            }
+        }
+        return result;
+    }
+
+public:
+    ///////////////////////////////////////////////////////////////////
+    // parallel terminal algorithms
+    ///////////////////////////////////////////////////////////////////
+    // all and any stop every piece, within chunk_size elements, once one
+    // of them has found the answer
+    template <typename Pred = std::identity>
+        requires std::predicate<Pred&, reference>
+    auto all(Pred pred = {}) -> bool
+    {
+        std::atomic<bool> found = false;
+        auto stopped = [&]{ return found.load(std::memory_order_relaxed); };
+        run([&](auto& piece){
+            auto check = [&](auto&& elem){
+                if (std::invoke(pred, RVR_FWD(elem))) {
+                    return true;
+                }
+                found.store(true, std::memory_order_relaxed);
+                return false;
+            };
+            return detail::while_batches(piece, stopped, check);
+        });
+        return not found.load(std::memory_order_relaxed);
+    }
+
+    template <typename Pred = std::identity>
+        requires std::predicate<Pred&, reference>
+    auto any(Pred pred = {}) -> bool
+    {
+        return not all(std::not_fn(pred));
+    }
+
+    // find(pred) finds the first element in order. Once a piece finds one,
+    // every piece after it stops
+    template <typename Pred>
+        requires std::predicate<Pred&, reference&>
+    auto find(Pred pred) -> tl::optional<value_t<Par>>
+    {
+        std::atomic<std::size_t> first = std::size_t(-1);
+        auto partials = run([&](auto& piece, std::size_t i){
+            auto later = [&]{ return first.load(std::memory_order_relaxed) < i; };
+            tl::optional<value_t<Par>> result;
+            auto check = [&](auto&& elem){
+                if (std::invoke(pred, elem)) {
+                    result.emplace(RVR_FWD(elem));
+                    return false;
+                }
+                return true;
+            };
+            detail::while_batches(piece, later, check);
+            if (result) {
+                std::size_t seen = first.load(std::memory_order_relaxed);
+                while (i < seen and not first.compare_exchange_weak(seen, i, std::memory_order_relaxed)) { }
+            }
+            return result;
+        });
+
+        for (auto& partial : partials) {
+            if (*partial) {
+                return std::move(*partial);
+            }
+        }
+        return tl::nullopt;
+    }
+
+    // fold(init, op) is sequential, fold(init, op, combine) is parallel
+    using RiverBase<Par>::fold;
+
+    // fold(init, op, combine)
+    // Each piece is folded with op starting from init, and then the partial
+    // results are combined, in order, with combine. As such, init has to be
+    // an identity of combine (e.g. 0 for +)
+    template <typename Z, typename F, typename C>
+        requires requires (F op, Z init, reference elem) {
+            { op(std::move(init), RVR_FWD(elem)) } -> std::convertible_to<Z>;
+        }
+        and std::regular_invocable<C&, Z, Z>
+    auto fold(Z init, F op, C combine) -> Z
+    {
+        auto partials = run([&](auto& piece){ return piece.fold(init, op); });
+        Z result = std::move(*partials.front());
+        for (std::size_t i = 1; i != partials.size(); ++i) {
+            result = combine(std::move(result), std::move(*partials[i]));
+        }
+        return result;
+    }
+
+    template <typename D=Par>
+    auto sum(value_t<D> init = {}) -> value_t<D>
+    {
+        for (auto& partial : run([](auto& piece){ return piece.sum(); })) {
+            init = init + *partial;
+        }
+        return init;
+    }
+
+    template <typename D=Par>
+    auto product(value_t<D> init = value_t<D>(1)) -> value_t<D>
+    {
+        for (auto& partial : run([](auto& piece){ return piece.product(); })) {
+            init = init * *partial;
+        }
+        return init;
+    }
+
+    auto count() -> int
+    {
+        int total = 0;
+        for (auto& partial : run([](auto& piece){ return piece.count(); })) {
+            total += *partial;
+        }
+        return total;
+    }
+
+    ///////////////////////////////////////////////////////////////////
+    // collecting into a vector (including into_vec) in parallel
+    ///////////////////////////////////////////////////////////////////
+
+    // so that collect<std::vector<T>>, collect<std::vector>(), and into_vec()
+    // all end up in collect_vector
+    template <typename T, typename A, typename P>
+        requires std::same_as<std::remove_cvref_t<P>, Par>
+    friend auto tag_invoke(collect_fn<std::vector<T, A>>, P&& r) -> std::vector<T, A> {
+        return r.template collect_vector<std::vector<T, A>>();
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////
+// ParTake: what take(n) on a parallel river produces. The first time it's
+// used, it finds its elements in parallel (see Par::first), and then it
+// produces them from there.
+////////////////////////////////////////////////////////////////////////////
+template <SplittableRiver R, executor E>
+struct ParTake : RiverBase<ParTake<R, E>>
+{
+private:
+    Par<R, E> base;
+    std::size_t n;
+    tl::optional<std::vector<value_t<R>>> elems;
+    std::size_t next = 0;
+
+public:
+    using reference = value_t<R>&;
+
+    ParTake(Par<R, E> base, int n)
+        : base(std::move(base))
+        , n(std::max(n, 0))
+    { }
+
+    auto while_(PredicateFor<reference> auto&& pred) -> bool {
+        if (not elems) {
+            elems.emplace(base.first(n));
+        }
+        while (next != elems->size()) {
+            if (not std::invoke(pred, (*elems)[next++])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    auto size_hint() const -> SizeHint {
+        if (elems) {
+            return SizeHint::exactly(elems->size() - next);
+        }
+        SizeHint const hint = rvr::size_hint(base);
+        return {.lower=std::min(hint.lower, n), .upper=hint.upper ? std::min(*hint.upper, n) : n};
+    }
+};
+
+struct {
+    template <SplittableRiver R>
+    auto operator()(R&& r) const {
+        return Par(RVR_FWD(r), default_pool());
+    }
+
+    template <SplittableRiver R, executor E>
+    auto operator()(R&& r, E& exec) const {
+        return Par(RVR_FWD(r), exec);
+    }
+} inline constexpr par;
+
+template <typename Derived>
+constexpr auto RiverBase<Derived>::par() & {
+    return Par(self(), default_pool());
+}
+
+template <typename Derived>
+constexpr auto RiverBase<Derived>::par() && {
+    return Par(std::move(self()), default_pool());
+}
+
+template <typename Derived>
+template <typename E>
+constexpr auto RiverBase<Derived>::par(E& exec) & {
+    static_assert(executor<E>);
+    return Par(self(), exec);
+}
+
+template <typename Derived>
+template <typename E>
+constexpr auto RiverBase<Derived>::par(E& exec) && {
+    static_assert(executor<E>);
+    return Par(std::move(self()), exec);
+}
+
+}
+
+#endif
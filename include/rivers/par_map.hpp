@@ -0,0 +1,302 @@
+#ifndef RIVERS_PAR_MAP_HPP
+#define RIVERS_PAR_MAP_HPP
+
+#include <rivers/core.hpp>
+#include <rivers/async_buffer.hpp>
+#include <rivers/thread_pool.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace rvr {
+
+////////////////////////////////////////////////////////////////////////////
+// par_map: takes a (RiverOf<T>, T -> U, workers, window) and produces a
+// RiverOf<U>, like map, except that f runs on up to workers tasks on the
+// default thread_pool at once (its concurrency, by default). Unlike par,
+// this doesn't need a river that can be split: the river is read on the
+// consuming thread, up to window elements (16 per worker, by default)
+// ahead of what has been produced, and f is applied to those elements in
+// parallel. So f is called from several threads at once.
+// * par_map keeps the order of the elements: the results wait in a reorder
+//   buffer until everything before them has been produced
+// * par_map_unordered produces results as soon as they're ready
+// While waiting for results, the consuming thread applies f too. If f
+// throws, the exception is rethrown in place of that element's result.
+// Elements that have been read ahead but not yet produced when the river
+// is destroyed are dropped (after waiting for any f still running on them).
+////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+    // The state shared between a ParMap and its tasks. The consuming thread
+    // puts the i-th element into slot order[i % window] and then bumps
+    // filled. Tasks claim elements by bumping claimed, and when f is done
+    // either mark the slot done or, if unordered, append it to completed.
+    template <typename T, typename U, typename F>
+    struct par_map_state {
+        struct alignas(64) slot {
+            tl::optional<T> input;
+            tl::optional<U> output;
+            std::exception_ptr error;
+            std::atomic<std::uint32_t> done = 0;
+        };
+
+        F f;
+        std::size_t window;
+        std::unique_ptr<slot[]> slots;
+        std::unique_ptr<std::size_t[]> order;
+        // slot + 1 of the i-th element to be done, if unordered. These (and
+        // done) are 32 bits, which is what a futex can wait on directly
+        std::unique_ptr<std::atomic<std::uint32_t>[]> completed;
+
+        alignas(64) std::atomic<std::size_t> filled = 0;
+        alignas(64) std::atomic<std::size_t> claimed = 0;
+        alignas(64) std::atomic<std::size_t> completions = 0;
+        std::atomic<std::size_t> active = 0;
+        std::atomic<bool> stopping = false;
+
+        par_map_state(F f, std::size_t window, bool ordered)
+            : f(std::move(f))
+            , window(window)
+            , slots(new slot[window])
+            , order(new std::size_t[window])
+        {
+            if (not ordered) {
+                completed.reset(new std::atomic<std::uint32_t>[window]);
+                for (std::size_t i = 0; i != window; ++i) {
+                    completed[i].store(0, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // claims and applies f to the next element, if there is one
+        auto run_one() -> bool {
+            std::size_t i = claimed.load(std::memory_order_relaxed);
+            do {
+                if (i == filled.load(std::memory_order_acquire)) {
+                    return false;
+                }
+            } while (not claimed.compare_exchange_weak(i, i + 1, std::memory_order_acquire,
+                                                              std::memory_order_relaxed));
+
+            std::size_t const id = order[i % window];
+            slot& s = slots[id];
+            try {
+                s.output.emplace(std::invoke(f, std::move(*s.input)));
+            } catch (...) {
+                s.error = std::current_exception();
+            }
+            s.input.reset();
+
+            if (completed) {
+                auto& entry = completed[completions.fetch_add(1, std::memory_order_relaxed) % window];
+                entry.store(static_cast<std::uint32_t>(id + 1), std::memory_order_release);
+                entry.notify_one();
+            } else {
+                s.done.store(1, std::memory_order_release);
+                s.done.notify_one();
+            }
+            return true;
+        }
+    };
+}
+
+template <River R, typename F, bool Ordered>
+struct ParMap : RiverBase<ParMap<R, F, Ordered>>
+{
+private:
+    using U = std::remove_cvref_t<std::invoke_result_t<F&, value_t<R>>>;
+    using state_t = detail::par_map_state<value_t<R>, U, F>;
+
+    R base;
+    std::shared_ptr<state_t> state;
+    std::size_t workers;
+    bool exhausted = false;
+
+    // consumer-side bookkeeping
+    std::size_t filled = 0;
+    std::size_t emitted = 0;
+    std::vector<std::size_t> free_slots;
+
+    void spawn() {
+        // only the consuming thread spawns, so this can't overshoot
+        if (state->active.load(std::memory_order_relaxed) < workers) {
+            state->active.fetch_add(1, std::memory_order_relaxed);
+            default_pool().execute([s=state]{
+                while (not s->stopping.load(std::memory_order_relaxed) and s->run_one()) { }
+                if (s->active.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    s->active.notify_all();
+                }
+            });
+        }
+    }
+
+    // reads ahead from base until the window is full
+    void refill() {
+        while (not exhausted and filled - emitted != state->window) {
+            exhausted = base.while_([&](reference_t<R> elem){
+                std::size_t const id = free_slots.back();
+                free_slots.pop_back();
+                state->slots[id].input.emplace(RVR_FWD(elem));
+                state->order[filled % state->window] = id;
+                state->filled.store(++filled, std::memory_order_release);
+                spawn();
+                return filled - emitted != state->window;
+            });
+        }
+    }
+
+    // Waits until done() - applying f to other elements in the meantime,
+    // then spinning, then sleeping on flag for it to stop being old
+    template <typename A, typename V, typename P>
+    void wait_for(A& flag, V old, P done) {
+        while (not done()) {
+            if (state->run_one()) {
+                continue;
+            }
+            for (int i = 0; i != 256 and detail::can_spin() and not done(); ++i) {
+                detail::cpu_relax();
+            }
+            if (not done()) {
+                flag.wait(old, std::memory_order_acquire);
+            }
+        }
+    }
+
+    // takes the next element to produce out of its slot
+    auto take_next() -> typename state_t::slot& {
+        std::size_t id;
+        if constexpr (Ordered) {
+            id = state->order[emitted % state->window];
+            auto& done = state->slots[id].done;
+            wait_for(done, 0u, [&]{ return done.load(std::memory_order_acquire) != 0; });
+        } else {
+            auto& entry = state->completed[emitted % state->window];
+            wait_for(entry, 0u, [&]{ return entry.load(std::memory_order_acquire) != 0; });
+            id = entry.load(std::memory_order_relaxed) - 1;
+            entry.store(0, std::memory_order_relaxed);
+        }
+        ++emitted;
+        free_slots.push_back(id);
+
+        auto& s = state->slots[id];
+        if constexpr (Ordered) {
+            s.done.store(0, std::memory_order_relaxed);
+        }
+        return s;
+    }
+
+public:
+    using reference = U;
+
+    ParMap(R base, F f, std::size_t workers, std::size_t window)
+        : base(std::move(base))
+        , workers(workers != 0 ? workers : default_pool().concurrency())
+    {
+        if (window == 0) {
+            window = 16 * this->workers;
+        }
+        state = std::make_shared<state_t>(std::move(f), window, Ordered);
+        free_slots.reserve(window);
+        for (std::size_t i = window; i != 0; --i) {
+            free_slots.push_back(i - 1);
+        }
+    }
+
+    ParMap(ParMap&&) = default;
+
+    ~ParMap() {
+        if (state) {
+            // the tasks may still be queued, so help the pool get to them
+            state->stopping.store(true, std::memory_order_relaxed);
+            for (std::size_t n; (n = state->active.load(std::memory_order_acquire)) != 0; ) {
+                if (not default_pool().try_run_one()) {
+                    state->active.wait(n, std::memory_order_acquire);
+                }
+            }
+        }
+    }
+
+    auto while_(PredicateFor<reference> auto&& pred) -> bool {
+        for (;;) {
+            refill();
+            if (emitted == filled) {
+                return true;
+            }
+
+            auto& s = take_next();
+            if (s.error) {
+                std::rethrow_exception(std::exchange(s.error, nullptr));
+            }
+            U value = std::move(*s.output);
+            s.output.reset();
+            if (not std::invoke(pred, std::move(value))) {
+                return false;
+            }
+        }
+    }
+
+    auto size_hint() const -> SizeHint {
+        SizeHint hint = rvr::size_hint(base);
+        if (exhausted) {
+            hint = SizeHint::exactly(0);
+        }
+        hint.lower += filled - emitted;
+        if (hint.upper) {
+            *hint.upper += filled - emitted;
+        }
+        return hint;
+    }
+};
+
+struct {
+    template <River R, typename F>
+        requires std::invocable<F&, value_t<R>>
+    auto operator()(R&& r, F&& f, std::size_t workers = 0, std::size_t window = 0) const {
+        return ParMap<std::remove_cvref_t<R>, std::decay_t<F>, true>(RVR_FWD(r), RVR_FWD(f), workers, window);
+    }
+} inline constexpr par_map;
+
+struct {
+    template <River R, typename F>
+        requires std::invocable<F&, value_t<R>>
+    auto operator()(R&& r, F&& f, std::size_t workers = 0, std::size_t window = 0) const {
+        return ParMap<std::remove_cvref_t<R>, std::decay_t<F>, false>(RVR_FWD(r), RVR_FWD(f), workers, window);
+    }
+} inline constexpr par_map_unordered;
+
+template <typename Derived>
+template <typename F>
+auto RiverBase<Derived>::par_map(F&& f, std::size_t workers, std::size_t window) & {
+    static_assert(std::invocable<F&, value_t<Derived>>);
+    return ParMap<Derived, std::decay_t<F>, true>(self(), RVR_FWD(f), workers, window);
+}
+
+template <typename Derived>
+template <typename F>
+auto RiverBase<Derived>::par_map(F&& f, std::size_t workers, std::size_t window) && {
+    static_assert(std::invocable<F&, value_t<Derived>>);
+    return ParMap<Derived, std::decay_t<F>, true>(std::move(self()), RVR_FWD(f), workers, window);
+}
+
+template <typename Derived>
+template <typename F>
+auto RiverBase<Derived>::par_map_unordered(F&& f, std::size_t workers, std::size_t window) & {
+    static_assert(std::invocable<F&, value_t<Derived>>);
+    return ParMap<Derived, std::decay_t<F>, false>(self(), RVR_FWD(f), workers, window);
+}
+
+template <typename Derived>
+template <typename F>
+auto RiverBase<Derived>::par_map_unordered(F&& f, std::size_t workers, std::size_t window) && {
+    static_assert(std::invocable<F&, value_t<Derived>>);
+    return ParMap<Derived, std::decay_t<F>, false>(std::move(self()), RVR_FWD(f), workers, window);
+}
+
+}
+
+#endif
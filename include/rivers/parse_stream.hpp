@@ -0,0 +1,188 @@
+#ifndef RIVERS_PARSE_STREAM_HPP
+#define RIVERS_PARSE_STREAM_HPP
+
+#include <rivers/core.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <istream>
+#include <memory>
+#include <system_error>
+
+#if __has_include(<unistd.h>)
+#include <unistd.h>
+#endif
+
+namespace rvr {
+
+////////////////////////////////////////////////////////////////////////////
+// parse_stream<T>: a faster from_stream<T> for numbers.
+// * parse_stream<T>(is)   for a std::istream&
+// * parse_stream<T>(file) for a FILE*
+// * parse_fd<T>(fd)       for a file descriptor
+// Reads the input in large blocks, splits it on whitespace, and parses each
+// token with std::from_chars (so there is no locale involved). Like
+// from_stream, parsing stops at the first token that isn't a valid T.
+// Neither the stream, the FILE*, nor the file descriptor is owned.
+////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+    template <typename T>
+    concept parseable = (std::integral<T> and not std::same_as<T, bool>)
+                     or std::floating_point<T>;
+
+    struct istream_source {
+        std::istream* is;
+
+        auto read(char* buf, std::size_t n) -> std::size_t {
+            return std::size_t(is->rdbuf()->sgetn(buf, std::streamsize(n)));
+        }
+    };
+
+    struct file_source {
+        std::FILE* file;
+
+        auto read(char* buf, std::size_t n) -> std::size_t {
+            return std::fread(buf, 1, n, file);
+        }
+    };
+
+#if __has_include(<unistd.h>)
+    struct fd_source {
+        int fd;
+
+        auto read(char* buf, std::size_t n) -> std::size_t {
+            for (;;) {
+                auto const r = ::read(fd, buf, n);
+                if (r >= 0) {
+                    return std::size_t(r);
+                } else if (errno != EINTR) {
+                    throw std::system_error(errno, std::generic_category(),
+                                            "rivers: could not read");
+                }
+            }
+        }
+    };
+#endif
+
+    constexpr auto is_space(char c) -> bool {
+        return c == ' ' or c == '\n' or c == '\t' or c == '\r' or c == '\v' or c == '\f';
+    }
+}
+
+template <detail::parseable T, typename Source>
+struct ParseStream : RiverBase<ParseStream<T, Source>>
+{
+private:
+    Source source;
+    std::size_t capacity;
+    std::unique_ptr<char[]> buffer;
+    char* pos = buffer.get();
+    char* end = buffer.get();
+    bool eof = false;
+
+    // Moves the unparsed part of the buffer to the front, and reads as much
+    // as fits after it. The buffer only grows if a single token fills it.
+    void refill() {
+        std::size_t const kept = end - pos;
+        if (kept == capacity) {
+            auto bigger = std::make_unique<char[]>(capacity * 2);
+            std::memcpy(bigger.get(), pos, kept);
+            buffer = std::move(bigger);
+            capacity *= 2;
+        } else {
+            std::memmove(buffer.get(), pos, kept);
+        }
+        pos = buffer.get();
+        end = pos + kept;
+
+        std::size_t const n = source.read(end, capacity - kept);
+        end += n;
+        eof = (n == 0);
+    }
+
+public:
+    using reference = T;
+
+    explicit ParseStream(Source source, std::size_t capacity = std::size_t(1) << 16)
+        : source(source)
+        , capacity(std::max<std::size_t>(capacity, 1))
+        , buffer(std::make_unique<char[]>(this->capacity))
+    { }
+
+    auto while_(PredicateFor<reference> auto&& pred) -> bool {
+        for (;;) {
+            pos = std::find_if_not(pos, end, detail::is_space);
+            if (pos == end) {
+                if (eof) {
+                    return true;
+                }
+                refill();
+                continue;
+            }
+
+            // from_chars doesn't accept a leading +, but >> does
+            char const* first = pos;
+            if (*first == '+' and end - first > 1 and first[1] != '-') {
+                ++first;
+            }
+
+            // let from_chars find the end of the token, and only look for it
+            // ourselves if it didn't stop at whitespace
+            T value{};
+            auto const [ptr, ec] = std::from_chars(first, end, value);
+            if (ec != std::errc() or ptr == end or not detail::is_space(*ptr)) {
+                // a token that runs to the end of the buffer could continue
+                // in the next block
+                if (std::find_if(pos, end, detail::is_space) == end and not eof) {
+                    refill();
+                    continue;
+                }
+
+                if (ec != std::errc() or ptr != end) {
+                    // not a T, so stop here for good
+                    end = pos;
+                    eof = true;
+                    return true;
+                }
+            }
+
+            pos += ptr - pos;
+            if (not std::invoke(pred, value)) {
+                return false;
+            }
+        }
+    }
+};
+
+template <detail::parseable T>
+struct parse_stream_fn {
+    auto operator()(std::istream& is) const {
+        return ParseStream<T, detail::istream_source>(detail::istream_source{&is});
+    }
+
+    auto operator()(std::FILE* file) const {
+        return ParseStream<T, detail::file_source>(detail::file_source{file});
+    }
+};
+
+template <detail::parseable T>
+inline constexpr parse_stream_fn<T> parse_stream;
+
+#if __has_include(<unistd.h>)
+template <detail::parseable T>
+struct parse_fd_fn {
+    auto operator()(int fd) const {
+        return ParseStream<T, detail::fd_source>(detail::fd_source{fd});
+    }
+};
+
+template <detail::parseable T>
+inline constexpr parse_fd_fn<T> parse_fd;
+#endif
+
+}
+
+#endif
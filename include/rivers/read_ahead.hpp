@@ -0,0 +1,572 @@
+#ifndef RIVERS_READ_AHEAD_HPP
+#define RIVERS_READ_AHEAD_HPP
+
+#if __has_include(<unistd.h>)
+#include <rivers/core.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <span>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#define RVR_IO_URING 1
+#endif
+
+namespace rvr {
+
+////////////////////////////////////////////////////////////////////////////
+// read_ahead(path): a river of the contents of a file, as consecutive
+// blocks of bytes (std::span<std::byte const>), which keeps reading ahead
+// of whatever is consuming it, so that I/O overlaps with computation.
+// * options.block_size is the size of each block (1MiB by default, rounded
+//   up to a multiple of 4KiB) - every block but the last is this size
+// * options.depth is how many blocks are read ahead (4 by default)
+// * options.direct opens the file with O_DIRECT, bypassing the page cache,
+//   for scans of files bigger than it (ignored where unsupported)
+// * options.io_uring can be set to false to always use a reader thread
+// Reads are issued with io_uring where available, and otherwise by a
+// background thread with pread. Either way, blocks come out in order, and
+// a block is only valid until the next one is asked for (since its buffer
+// is then reused for reading further ahead). The size of the file is taken
+// when it's opened. Errors are thrown as std::system_error.
+// Unlike from_file, this doesn't map the file, so memory use is bounded by
+// block_size * depth however big the file is.
+////////////////////////////////////////////////////////////////////////////
+
+struct ReadAheadOptions {
+    std::size_t block_size = std::size_t(1) << 20;
+    std::size_t depth = 4;
+    bool direct = false;
+    bool io_uring = true;
+};
+
+namespace detail {
+    // the file being read, and the buffers its blocks are read into - block i
+    // goes in buffer i % depth
+    class block_file {
+        static constexpr std::size_t alignment = 4096;
+
+        struct aligned_delete {
+            void operator()(std::byte* p) const {
+                ::operator delete[](p, std::align_val_t(alignment));
+            }
+        };
+
+        int fd_ = -1;
+        std::size_t size_ = 0;
+        std::size_t block_size_;
+        std::size_t depth_;
+        std::unique_ptr<std::byte[], aligned_delete> buffers;
+
+    public:
+        block_file(std::filesystem::path const& path, ReadAheadOptions const& options)
+            : block_size_((std::max<std::size_t>(options.block_size, 1) + alignment - 1)
+                          / alignment * alignment)
+            , depth_(std::clamp<std::size_t>(options.depth, 1, 4096))
+        {
+            int flags = O_RDONLY | O_CLOEXEC;
+#ifdef O_DIRECT
+            if (options.direct) {
+                fd_ = ::open(path.c_str(), flags | O_DIRECT);
+            }
+#endif
+            // some file systems (like tmpfs) don't do O_DIRECT
+            if (fd_ < 0) {
+                fd_ = ::open(path.c_str(), flags);
+            }
+            if (fd_ < 0) {
+                throw std::system_error(errno, std::generic_category(),
+                                        "rivers: could not open " + path.string());
+            }
+
+            struct stat st;
+            if (::fstat(fd_, &st) != 0) {
+                int const error = errno;
+                ::close(fd_);
+                throw std::system_error(error, std::generic_category(),
+                                        "rivers: could not stat " + path.string());
+            }
+            size_ = std::size_t(st.st_size);
+
+            ::posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+            // no more buffers than blocks, for small files
+            depth_ = std::max<std::size_t>(std::min(depth_, count()), 1);
+            buffers.reset(new (std::align_val_t(alignment)) std::byte[depth_ * block_size_]);
+        }
+
+        block_file(block_file const&) = delete;
+        auto operator=(block_file const&) -> block_file& = delete;
+
+        ~block_file() {
+            ::close(fd_);
+        }
+
+        auto fd() const -> int { return fd_; }
+        auto block_size() const -> std::size_t { return block_size_; }
+        auto depth() const -> std::size_t { return depth_; }
+
+        // the number of blocks
+        auto count() const -> std::size_t {
+            return (size_ + block_size_ - 1) / block_size_;
+        }
+
+        auto offset(std::size_t i) const -> std::size_t {
+            return i * block_size_;
+        }
+
+        // how many bytes block i should have
+        auto extent(std::size_t i) const -> std::size_t {
+            return std::min(block_size_, size_ - offset(i));
+        }
+
+        auto buffer(std::size_t i) const -> std::byte* {
+            return buffers.get() + (i % depth_) * block_size_;
+        }
+    };
+
+    inline void throw_read_error(int error) {
+        throw std::system_error(error, std::generic_category(), "rivers: could not read");
+    }
+
+    // The progress of reading one block. It's complete once it has all of
+    // its bytes, or has hit the end of the file (if it shrank since it was
+    // opened), or failed.
+    struct block_state {
+        std::size_t got = 0;
+        int error = 0;
+        bool complete = false;
+    };
+
+    // reads ahead with a background thread, which reads each block with
+    // pread as soon as its buffer is free
+    class thread_block_reader {
+        block_file& file;
+        std::vector<block_state> states;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::size_t released = 0; // blocks whose buffers can be reused
+        bool stopping = false;
+        std::thread thread;
+
+        void run() {
+            for (std::size_t i = 0; i != file.count(); ++i) {
+                {
+                    std::unique_lock lock(mutex);
+                    cv.wait(lock, [&]{ return stopping or i < released + file.depth(); });
+                    if (stopping) {
+                        return;
+                    }
+                }
+
+                block_state state;
+                std::size_t const n = file.extent(i);
+                while (state.got < n) {
+                    auto const r = ::pread(file.fd(), file.buffer(i) + state.got,
+                                           file.block_size() - state.got,
+                                           off_t(file.offset(i) + state.got));
+                    if (r > 0) {
+                        state.got += std::size_t(r);
+                    } else if (r == 0) {
+                        break;
+                    } else if (errno != EINTR) {
+                        state.error = errno;
+                        break;
+                    }
+                }
+                state.complete = true;
+
+                std::lock_guard lock(mutex);
+                states[i % file.depth()] = state;
+                cv.notify_all();
+                if (state.error != 0) {
+                    return;
+                }
+            }
+        }
+
+    public:
+        explicit thread_block_reader(block_file& file)
+            : file(file)
+            , states(file.depth())
+            , thread([this]{ run(); })
+        { }
+
+        ~thread_block_reader() {
+            {
+                std::lock_guard lock(mutex);
+                stopping = true;
+            }
+            cv.notify_all();
+            thread.join();
+        }
+
+        // waits for block i to have been read, returning its bytes
+        auto wait(std::size_t i) -> std::span<std::byte const> {
+            std::unique_lock lock(mutex);
+            block_state& state = states[i % file.depth()];
+            cv.wait(lock, [&]{ return state.complete; });
+            if (state.error != 0) {
+                throw_read_error(state.error);
+            }
+            return {file.buffer(i), state.got};
+        }
+
+        // lets block i's buffer be reused
+        void release(std::size_t i) {
+            std::lock_guard lock(mutex);
+            states[i % file.depth()] = {};
+            released = i + 1;
+            cv.notify_all();
+        }
+    };
+
+#ifdef RVR_IO_URING
+    ////////////////////////////////////////////////////////////////////////
+    // Just enough of io_uring to issue reads and wait for them, straight
+    // through the system calls (so there's no dependency on liburing).
+    // The submission and completion queues are rings shared with the
+    // kernel: we write entries and then publish them by moving the
+    // submission tail, and the kernel publishes completions by moving the
+    // completion tail.
+    ////////////////////////////////////////////////////////////////////////
+    class io_ring {
+        int fd = -1;
+        void* sq_ring = MAP_FAILED;
+        std::size_t sq_ring_size = 0;
+        void* cq_ring = MAP_FAILED;
+        std::size_t cq_ring_size = 0;
+        io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+        std::size_t sqes_size = 0;
+
+        unsigned* sq_tail = nullptr;
+        unsigned sq_mask = 0;
+        unsigned* sq_array = nullptr;
+        unsigned* cq_head = nullptr;
+        unsigned* cq_tail = nullptr;
+        unsigned cq_mask = 0;
+        io_uring_cqe* cqes = nullptr;
+        unsigned unsubmitted = 0;
+
+        template <typename T>
+        static auto at(void* ring, unsigned offset) -> T* {
+            return reinterpret_cast<T*>(static_cast<char*>(ring) + offset);
+        }
+
+        auto enter(unsigned to_submit, unsigned min_complete, unsigned flags) -> int {
+            return int(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+                                 flags, nullptr, 0));
+        }
+
+    public:
+        // sets up a ring for up to entries reads at once, returning false if
+        // io_uring is unavailable (or too old to have IORING_OP_READ)
+        auto setup(unsigned entries) -> bool {
+            io_uring_params params = {};
+            fd = int(::syscall(__NR_io_uring_setup, entries, &params));
+            if (fd < 0) {
+                return false;
+            }
+            // IORING_OP_READ came in 5.6, and this feature in 5.7
+            if (not (params.features & IORING_FEAT_FAST_POLL)) {
+                return false;
+            }
+
+            sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            bool const single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+            if (single_mmap) {
+                sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+            }
+
+            sq_ring = ::mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+            if (sq_ring == MAP_FAILED) {
+                return false;
+            }
+            if (not single_mmap) {
+                cq_ring = ::mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE,
+                                 MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+                if (cq_ring == MAP_FAILED) {
+                    return false;
+                }
+            }
+            sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+            sqes = static_cast<io_uring_sqe*>(::mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE,
+                                                     MAP_SHARED | MAP_POPULATE, fd,
+                                                     IORING_OFF_SQES));
+            if (sqes == MAP_FAILED) {
+                return false;
+            }
+
+            void* const cq = single_mmap ? sq_ring : cq_ring;
+            sq_tail = at<unsigned>(sq_ring, params.sq_off.tail);
+            sq_mask = *at<unsigned>(sq_ring, params.sq_off.ring_mask);
+            sq_array = at<unsigned>(sq_ring, params.sq_off.array);
+            cq_head = at<unsigned>(cq, params.cq_off.head);
+            cq_tail = at<unsigned>(cq, params.cq_off.tail);
+            cq_mask = *at<unsigned>(cq, params.cq_off.ring_mask);
+            cqes = at<io_uring_cqe>(cq, params.cq_off.cqes);
+            return true;
+        }
+
+        io_ring() = default;
+        io_ring(io_ring const&) = delete;
+        auto operator=(io_ring const&) -> io_ring& = delete;
+
+        ~io_ring() {
+            if (sqes != MAP_FAILED) {
+                ::munmap(sqes, sqes_size);
+            }
+            if (cq_ring != MAP_FAILED) {
+                ::munmap(cq_ring, cq_ring_size);
+            }
+            if (sq_ring != MAP_FAILED) {
+                ::munmap(sq_ring, sq_ring_size);
+            }
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+
+        // queues a read of n bytes at offset off of file into p, to be
+        // submitted by submit()
+        void read(int file, void* p, std::size_t n, std::size_t off, std::uint64_t user_data) {
+            // only we write the submission tail
+            unsigned const tail = *sq_tail;
+            unsigned const index = tail & sq_mask;
+            io_uring_sqe& sqe = sqes[index];
+            std::memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = IORING_OP_READ;
+            sqe.fd = file;
+            sqe.addr = reinterpret_cast<std::uintptr_t>(p);
+            sqe.len = unsigned(n);
+            sqe.off = off;
+            sqe.user_data = user_data;
+            sq_array[index] = index;
+            std::atomic_ref(*sq_tail).store(tail + 1, std::memory_order_release);
+            ++unsubmitted;
+        }
+
+        void submit() {
+            while (unsubmitted != 0) {
+                int const r = enter(unsubmitted, 0, 0);
+                if (r >= 0) {
+                    unsubmitted -= unsigned(r);
+                } else if (errno != EINTR and errno != EAGAIN and errno != EBUSY) {
+                    throw std::system_error(errno, std::generic_category(),
+                                            "rivers: could not submit to io_uring");
+                }
+            }
+        }
+
+        // waits for a read to complete, returning its user_data and result
+        auto wait() -> io_uring_cqe {
+            // only we write the completion head
+            unsigned const head = *cq_head;
+            while (std::atomic_ref(*cq_tail).load(std::memory_order_acquire) == head) {
+                if (enter(0, 1, IORING_ENTER_GETEVENTS) < 0 and errno != EINTR) {
+                    throw std::system_error(errno, std::generic_category(),
+                                            "rivers: could not wait on io_uring");
+                }
+            }
+            io_uring_cqe const cqe = cqes[head & cq_mask];
+            std::atomic_ref(*cq_head).store(head + 1, std::memory_order_release);
+            return cqe;
+        }
+    };
+
+    // reads ahead by keeping a read in flight for every free buffer
+    class uring_block_reader {
+        block_file& file;
+        io_ring& ring;
+        std::vector<block_state> states;
+        std::size_t in_flight = 0;
+
+        // (re)issues the read of whatever's left of block i
+        void read(std::size_t i) {
+            block_state const& state = states[i % file.depth()];
+            ring.read(file.fd(), file.buffer(i) + state.got, file.block_size() - state.got,
+                      file.offset(i) + state.got, i);
+            ++in_flight;
+        }
+
+        // handles one completion
+        void complete_one() {
+            io_uring_cqe const cqe = ring.wait();
+            --in_flight;
+            auto const i = std::size_t(cqe.user_data);
+            block_state& state = states[i % file.depth()];
+            if (cqe.res > 0) {
+                state.got += std::size_t(cqe.res);
+                state.complete = state.got >= file.extent(i);
+            } else if (cqe.res == 0) {
+                state.complete = true;
+            } else if (cqe.res != -EINTR and cqe.res != -EAGAIN) {
+                state.error = -cqe.res;
+                state.complete = true;
+            }
+            if (not state.complete) {
+                read(i);
+                ring.submit();
+            }
+        }
+
+    public:
+        uring_block_reader(block_file& file, io_ring& ring)
+            : file(file)
+            , ring(ring)
+            , states(file.depth())
+        {
+            for (std::size_t i = 0; i != std::min(file.depth(), file.count()); ++i) {
+                read(i);
+            }
+            ring.submit();
+        }
+
+        uring_block_reader(uring_block_reader const&) = delete;
+        auto operator=(uring_block_reader const&) -> uring_block_reader& = delete;
+
+        // the kernel may still be writing into the buffers
+        ~uring_block_reader() {
+            while (in_flight != 0) {
+                ring.wait();
+                --in_flight;
+            }
+        }
+
+        auto wait(std::size_t i) -> std::span<std::byte const> {
+            block_state const& state = states[i % file.depth()];
+            while (not state.complete) {
+                complete_one();
+            }
+            if (state.error != 0) {
+                throw_read_error(state.error);
+            }
+            return {file.buffer(i), state.got};
+        }
+
+        void release(std::size_t i) {
+            states[i % file.depth()] = {};
+            if (i + file.depth() < file.count()) {
+                read(i + file.depth());
+                ring.submit();
+            }
+        }
+    };
+#endif
+
+    // the state behind a ReadAhead, which stays put while the river moves
+    struct read_ahead_state {
+        block_file file;
+#ifdef RVR_IO_URING
+        io_ring ring;
+        std::unique_ptr<uring_block_reader> uring_reader;
+#endif
+        std::unique_ptr<thread_block_reader> thread_reader;
+
+        read_ahead_state(std::filesystem::path const& path, ReadAheadOptions const& options)
+            : file(path, options)
+        {
+#ifdef RVR_IO_URING
+            if (options.io_uring and ring.setup(unsigned(file.depth()))) {
+                uring_reader = std::make_unique<uring_block_reader>(file, ring);
+                return;
+            }
+#endif
+            thread_reader = std::make_unique<thread_block_reader>(file);
+        }
+
+        auto wait(std::size_t i) -> std::span<std::byte const> {
+#ifdef RVR_IO_URING
+            if (uring_reader) {
+                return uring_reader->wait(i);
+            }
+#endif
+            return thread_reader->wait(i);
+        }
+
+        void release(std::size_t i) {
+#ifdef RVR_IO_URING
+            if (uring_reader) {
+                return uring_reader->release(i);
+            }
+#endif
+            thread_reader->release(i);
+        }
+    };
+}
+
+struct ReadAhead : RiverBase<ReadAhead>
+{
+private:
+    std::unique_ptr<detail::read_ahead_state> state;
+    std::size_t current = 0; // the next block to hand out
+    std::size_t end;         // the number of blocks
+    bool holding = false;    // whether block current - 1 is still in use
+
+public:
+    using reference = std::span<std::byte const>;
+
+    explicit ReadAhead(std::unique_ptr<detail::read_ahead_state> s)
+        : state(std::move(s))
+        , end(state->file.count())
+    { }
+
+    auto while_(PredicateFor<reference> auto&& pred) -> bool {
+        for (;;) {
+            if (holding) {
+                state->release(current - 1);
+                holding = false;
+            }
+            if (current == end) {
+                return true;
+            }
+
+            auto const block = state->wait(current);
+            // a short block means the file shrank, and there's nothing after it
+            if (block.size() < state->file.extent(current)) {
+                end = current + 1;
+            }
+            ++current;
+            holding = true;
+            if (not block.empty() and not std::invoke(pred, block)) {
+                return false;
+            }
+        }
+    }
+
+    auto size_hint() const -> SizeHint {
+        return {.lower=0, .upper=end - current};
+    }
+};
+
+struct {
+    auto operator()(std::filesystem::path const& path, ReadAheadOptions options = {}) const {
+        return ReadAhead(std::make_unique<detail::read_ahead_state>(path, options));
+    }
+} inline constexpr read_ahead;
+
+}
+
+#endif
+
+#endif
@@ -25,6 +25,32 @@ public:
         return base->while_(RVR_FWD(pred));
     }
 
+    constexpr void for_all(std::invocable<reference> auto&& op)
+        requires ExhaustiveRiver<R>
+    {
+        base->for_all(RVR_FWD(op));
+    }
+
+    constexpr auto while_chunk(PredicateFor<chunk_t<Ref>> auto&& pred) -> bool
+        requires ChunkedRiver<R>
+    {
+        return base->while_chunk(RVR_FWD(pred));
+    }
+
+    constexpr auto size_hint() const -> SizeHint {
+        return rvr::size_hint(*base);
+    }
+
+    constexpr auto advance(std::size_t n) -> std::size_t
+        requires AdvanceableRiver<R>
+    {
+        return base->advance(n);
+    }
+
+    constexpr auto remaining() const requires ContiguousRiver<R> {
+        return base->remaining();
+    }
+
     void reset() requires ResettableRiver<R> {
         base->reset();
     }
@@ -3,18 +3,30 @@
 
 #include <rivers/core.hpp>
 
+#include <rivers/async_buffer.hpp>
 #include <rivers/chain.hpp>
+#include <rivers/channel.hpp>
+#include <rivers/char_class.hpp>
 #include <rivers/collect.hpp>
+#include <rivers/csv.hpp>
 #include <rivers/drop.hpp>
 #include <rivers/filter.hpp>
+#include <rivers/from_file.hpp>
 #include <rivers/from_stream.hpp>
 #include <rivers/from.hpp>
 #include <rivers/map.hpp>
 #include <rivers/of.hpp>
+#include <rivers/parse_stream.hpp>
+#include <rivers/thread_pool.hpp>
+#include <rivers/par.hpp>
+#include <rivers/par_map.hpp>
+#include <rivers/read_ahead.hpp>
 #include <rivers/ref.hpp>
 #include <rivers/seq.hpp>
 #include <rivers/split.hpp>
+#include <rivers/stop.hpp>
 #include <rivers/take.hpp>
+#include <rivers/write.hpp>
 
 #include <rivers/format.hpp>
 
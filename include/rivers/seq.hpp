@@ -2,6 +2,9 @@
 #define RIVERS_SEQ_HPP
 
 #include <rivers/core.hpp>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
 
 namespace rvr {
 
@@ -11,6 +14,13 @@ namespace rvr {
 // seq(5) includes the elements [0, 1, 2, 3, 4]
 // Like std::views::iota, except that seq(e) are the elements in [E(), e)
 // rather than the  being the elements in [e, inf)
+//
+// For integers, seq(from, to, step) counts by step, stopping before
+// reaching to (counting down if step is negative, which must not be 0):
+// seq(0, 10, 3) includes the elements [0, 3, 6, 9]
+// seq(5, 0, -2) includes the elements [5, 3, 1]
+// Integer seqs compute sum, count, next, size_hint, drop, and take in
+// constant time.
 ////////////////////////////////////////////////////////////////////////////
 template <std::weakly_incrementable I>
     requires std::equality_comparable<I>
@@ -37,6 +47,150 @@ public:
         return true;
     }
 
+    constexpr void for_all(std::invocable<reference> auto&& op) {
+        for (; from != to; ++from) {
+            std::invoke(op, I(from));
+        }
+    }
+
+    constexpr auto size_hint() const -> SizeHint
+        requires std::sized_sentinel_for<I, I>
+    {
+        return SizeHint::exactly(to - from);
+    }
+
+    void reset() {
+        from = orig;
+    }
+};
+
+template <std::weakly_incrementable I>
+    requires std::equality_comparable<I> and std::integral<I>
+struct Seq<I> : RiverBase<Seq<I>>
+{
+private:
+    using U = std::make_unsigned_t<I>;
+    using D = std::make_signed_t<I>;
+    // all the arithmetic is done in (at least) unsigned int, which wraps
+    // rather than overflowing
+    using W = std::common_type_t<U, unsigned>;
+
+    I from = I();
+    I to;
+    D step = 1;
+    I orig = from;
+
+    constexpr auto remaining() const -> U {
+        if (step > 0 ? from >= to : from <= to) {
+            return 0;
+        }
+        U const distance = step > 0 ? U(U(to) - U(from)) : U(U(from) - U(to));
+        W const stride = step > 0 ? W(step) : W(0) - W(step);
+        return U((W(distance) - 1) / stride + 1);
+    }
+
+    // the element k steps after from
+    constexpr auto nth(U k) const -> I {
+        return I(U(W(U(from)) + W(k) * W(U(step))));
+    }
+
+public:
+    using reference = I;
+
+    explicit constexpr Seq(I from, I to, D step = 1) : from(from), to(to), step(step) { }
+    explicit constexpr Seq(I to) : to(to) { }
+
+    constexpr auto while_(PredicateFor<reference> auto&& pred) -> bool {
+        for (U n = remaining(); n != 0; --n) {
+            I const elem = from;
+            from = n == 1 ? to : nth(1);
+            if (not std::invoke(pred, I(elem))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // a counted loop, which the compiler can vectorize
+    constexpr void for_all(std::invocable<reference> auto&& op) {
+        U const n = remaining();
+        I elem = std::exchange(from, to);
+        for (U k = 0; k != n; ++k) {
+            std::invoke(op, I(elem));
+            elem = I(U(W(U(elem)) + W(U(step))));
+        }
+    }
+
+    constexpr auto next() -> tl::optional<I> {
+        if (remaining() == 0) {
+            return tl::nullopt;
+        }
+        I const elem = from;
+        advance(1);
+        return elem;
+    }
+
+    // n * from + step * n * (n - 1) / 2, dividing whichever of n and n - 1
+    // is even by 2 first, so that the product doesn't need to be wider
+    constexpr auto sum(I init = I()) -> I {
+        U const n = remaining();
+        W const triangle = n % 2 == 0 ? W(n / 2) * W(U(n - 1))
+                                      : W(n) * W(U((n - 1) / 2));
+        W const total = W(n) * W(U(from)) + triangle * W(U(step));
+        from = to;
+        return I(U(W(U(init)) + total));
+    }
+
+    constexpr auto count() -> int {
+        int const n = int(remaining());
+        from = to;
+        return n;
+    }
+
+    constexpr auto size_hint() const -> SizeHint {
+        return SizeHint::exactly(remaining());
+    }
+
+    constexpr auto advance(std::size_t n) -> std::size_t {
+        U const k = remaining();
+        if (n < k) {
+            from = nth(U(n));
+            return n;
+        } else {
+            from = to;
+            return k;
+        }
+    }
+
+    // drop and take produce another seq, rather than an adapter
+    constexpr auto drop(int n) const -> Seq {
+        Seq rest = *this;
+        rest.advance(std::size_t(std::max(n, 0)));
+        rest.orig = rest.from;
+        return rest;
+    }
+
+    constexpr auto take(int n) const -> Seq {
+        Seq prefix = *this;
+        if (U(std::max(n, 0)) < remaining()) {
+            prefix.to = nth(U(std::max(n, 0)));
+        }
+        prefix.orig = prefix.from;
+        return prefix;
+    }
+
+    constexpr auto try_split() -> tl::optional<Seq> {
+        U const n = remaining();
+        if (n < 2) {
+            return tl::nullopt;
+        }
+
+        I const mid = nth(n / 2);
+        auto prefix = Seq(from, mid, step);
+        from = mid;
+        return prefix;
+    }
+
     void reset() {
         from = orig;
     }
@@ -54,6 +208,12 @@ struct {
     constexpr auto operator()(I to) const {
         return Seq(std::move(to));
     }
+
+    template <std::integral I, std::integral S>
+        requires std::weakly_incrementable<I>
+    constexpr auto operator()(I from, I to, S step) const {
+        return Seq<I>(from, to, std::make_signed_t<I>(step));
+    }
 } inline constexpr seq;
 
 }
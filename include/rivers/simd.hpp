@@ -0,0 +1,495 @@
+#ifndef RIVERS_SIMD_HPP
+#define RIVERS_SIMD_HPP
+
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <span>
+#include <type_traits>
+
+////////////////////////////////////////////////////////////////////////////
+// Explicitly vectorized kernels, used by the terminal algorithms when they
+// are handed contiguous blocks (see ChunkedRiver).
+// On x86-64 with gcc or clang, each kernel is compiled both for the
+// baseline (SSE2) and for AVX2, and the right one is picked at runtime
+// based on CPUID. Everywhere else, they are plain loops.
+////////////////////////////////////////////////////////////////////////////
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define RVR_SIMD_X86 1
+#else
+#define RVR_SIMD_X86 0
+#endif
+
+#if RVR_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace rvr::detail::simd {
+
+// Only integers are reduced with vectors: the kernels do the arithmetic on
+// the unsigned type, where wrapping is well-defined and associative, so
+// the result is exactly what a sequential (wrapping) fold would give.
+// Reassociating floating point sums would change the result.
+template <typename T>
+concept reducible = std::integral<T> and not std::same_as<T, bool>;
+
+// Applies op in at least unsigned int, so that narrower types don't get
+// promoted to int (where they could overflow)
+template <reducible T, typename Op>
+inline auto apply(Op op, T a, T b) -> T {
+    using W = std::common_type_t<T, unsigned>;
+    return T(op(W(a), W(b)));
+}
+
+template <reducible T, typename Op>
+inline auto reduce_scalar(T const* p, std::size_t n, T identity, Op op) -> T {
+    T result = identity;
+    for (std::size_t i = 0; i != n; ++i) {
+        result = simd::apply(op, result, p[i]);
+    }
+    return result;
+}
+
+#if RVR_SIMD_X86
+// acc = op(acc, v) for vectors, taking them by reference so that no vector
+// crosses a function boundary compiled for a different target
+template <typename Op, typename V>
+[[gnu::always_inline]] inline void combine(V& acc, V const& v) {
+    static_assert(std::same_as<Op, std::plus<>> or std::same_as<Op, std::multiplies<>>);
+    if constexpr (std::same_as<Op, std::plus<>>) {
+        acc += v;
+    } else {
+        acc *= v;
+    }
+}
+
+// Reduce using W-byte vectors, with four independent accumulators so that
+// we're not bound by the latency of the operation.
+// This is always inlined into a caller that is compiled for the target
+// that supports W-byte vectors.
+template <std::size_t W, reducible T, typename Op>
+[[gnu::always_inline]] inline auto reduce_with(T const* p, std::size_t n, T identity, Op op) -> T {
+    using V [[gnu::vector_size(W)]] = T;
+    constexpr std::size_t L = W / sizeof(T);
+
+    V acc[4];
+    for (V& a : acc) {
+        a = V{} + identity;
+    }
+
+    std::size_t i = 0;
+    for (; i + 4 * L <= n; i += 4 * L) {
+        for (std::size_t k = 0; k != 4; ++k) {
+            V v;
+            std::memcpy(&v, p + i + k * L, W);
+            simd::combine<Op>(acc[k], v);
+        }
+    }
+    for (; i + L <= n; i += L) {
+        V v;
+        std::memcpy(&v, p + i, W);
+        simd::combine<Op>(acc[0], v);
+    }
+
+    simd::combine<Op>(acc[0], acc[1]);
+    simd::combine<Op>(acc[2], acc[3]);
+    simd::combine<Op>(acc[0], acc[2]);
+    T result = identity;
+    for (std::size_t k = 0; k != L; ++k) {
+        result = simd::apply(op, result, T(acc[0][k]));
+    }
+    return simd::apply(op, result, reduce_scalar(p + i, n - i, identity, op));
+}
+
+template <reducible T, typename Op>
+inline auto reduce_sse2(T const* p, std::size_t n, T identity, Op op) -> T {
+    return reduce_with<16>(p, n, identity, op);
+}
+
+template <reducible T, typename Op>
+[[gnu::target("avx2")]]
+inline auto reduce_avx2(T const* p, std::size_t n, T identity, Op op) -> T {
+    return reduce_with<32>(p, n, identity, op);
+}
+
+inline auto has_avx2() -> bool {
+    static bool const result = __builtin_cpu_supports("avx2");
+    return result;
+}
+#endif
+
+template <reducible T, typename Op>
+inline auto reduce(std::span<T const> chunk, T identity, Op op) -> T {
+    using U = std::make_unsigned_t<T>;
+    // accessing a T through its unsigned counterpart is fine
+    auto const p = reinterpret_cast<U const*>(chunk.data());
+    auto const n = chunk.size();
+#if RVR_SIMD_X86
+    if (has_avx2()) {
+        return T(reduce_avx2(p, n, U(identity), op));
+    } else {
+        return T(reduce_sse2(p, n, U(identity), op));
+    }
+#else
+    return T(reduce_scalar(p, n, U(identity), op));
+#endif
+}
+
+template <reducible T>
+inline auto sum(std::span<T const> chunk) -> T {
+    return simd::reduce(chunk, T(0), std::plus());
+}
+
+template <reducible T>
+inline auto product(std::span<T const> chunk) -> T {
+    return simd::reduce(chunk, T(1), std::multiplies());
+}
+
+////////////////////////////////////////////////////////////////////////////
+// compress(p, keep, n, out): copies every p[i] for which keep[i] is true to
+// out, in order, and returns how many were copied (like std::copy_if, given
+// the results of the predicate up front).
+// 4- and 8-byte types are compressed a vector at a time: with AVX-512,
+// using vpcompressd/q, and with AVX2 by looking up a lane permutation for
+// each mask in a table. Since whole vectors are stored, up to
+// compress_slack elements past the last one copied can be written to.
+// Everything else is copied without branching on keep.
+////////////////////////////////////////////////////////////////////////////
+inline constexpr std::size_t compress_slack = 16;
+
+template <typename T>
+inline auto compress_scalar(T const* p, bool const* keep, std::size_t n, T* out) -> std::size_t {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i != n; ++i) {
+        out[count] = p[i];
+        count += keep[i];
+    }
+    return count;
+}
+
+#if RVR_SIMD_X86
+// For each mask of 8 lanes, the indices of the set lanes in order, one per
+// byte - the permutation that moves the kept lanes to the front.
+// For 4 lanes of 64 bits, the same for pairs of 32-bit lanes.
+struct compress_tables {
+    std::array<std::uint64_t, 256> lanes8 = {};
+    std::array<std::uint64_t, 16> lanes4 = {};
+};
+
+constexpr auto make_compress_tables() -> compress_tables {
+    compress_tables tables;
+    for (unsigned mask = 0; mask != 256; ++mask) {
+        int k = 0;
+        for (unsigned lane = 0; lane != 8; ++lane) {
+            if (mask & (1u << lane)) {
+                tables.lanes8[mask] |= std::uint64_t(lane) << (8 * k++);
+            }
+        }
+    }
+    for (unsigned mask = 0; mask != 16; ++mask) {
+        int k = 0;
+        for (unsigned lane = 0; lane != 4; ++lane) {
+            if (mask & (1u << lane)) {
+                tables.lanes4[mask] |= std::uint64_t(2 * lane) << (8 * k++);
+                tables.lanes4[mask] |= std::uint64_t(2 * lane + 1) << (8 * k++);
+            }
+        }
+    }
+    return tables;
+}
+
+inline constexpr compress_tables compress_table = make_compress_tables();
+
+// the keep bits of the 32 elements starting at keep
+[[gnu::target("avx2"), gnu::always_inline]]
+inline auto keep_bits(bool const* keep) -> std::uint32_t {
+    __m256i const k = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(keep));
+    return std::uint32_t(_mm256_movemask_epi8(_mm256_cmpgt_epi8(k, _mm256_setzero_si256())));
+}
+
+template <typename T>
+[[gnu::target("avx2,popcnt")]]
+inline auto compress_avx2(T const* p, bool const* keep, std::size_t n, T* out) -> std::size_t {
+    constexpr unsigned L = 32 / sizeof(T);
+    constexpr unsigned lane_mask = (1u << L) - 1;
+    std::size_t count = 0;
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        std::uint32_t const bits = keep_bits(keep + i);
+        for (unsigned j = 0; j != 32 / L; ++j) {
+            unsigned const m = (bits >> (j * L)) & lane_mask;
+            std::uint64_t const lanes = L == 8 ? compress_table.lanes8[m]
+                                               : compress_table.lanes4[m];
+            __m256i const idx = _mm256_cvtepu8_epi32(_mm_cvtsi64_si128(std::int64_t(lanes)));
+            __m256i const v = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p + i + j * L));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + count),
+                                _mm256_permutevar8x32_epi32(v, idx));
+            count += std::popcount(m);
+        }
+    }
+    return count + compress_scalar(p + i, keep + i, n - i, out + count);
+}
+
+template <typename T>
+[[gnu::target("avx512f,avx2,popcnt")]]
+inline auto compress_avx512(T const* p, bool const* keep, std::size_t n, T* out) -> std::size_t {
+    constexpr unsigned L = 64 / sizeof(T);
+    constexpr unsigned lane_mask = (1u << L) - 1;
+    std::size_t count = 0;
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        std::uint32_t const bits = keep_bits(keep + i);
+        for (unsigned j = 0; j != 32 / L; ++j) {
+            unsigned const m = (bits >> (j * L)) & lane_mask;
+            __m512i const v = _mm512_loadu_si512(p + i + j * L);
+            if constexpr (L == 16) {
+                _mm512_storeu_si512(out + count, _mm512_maskz_compress_epi32(__mmask16(m), v));
+            } else {
+                _mm512_storeu_si512(out + count, _mm512_maskz_compress_epi64(__mmask8(m), v));
+            }
+            count += std::popcount(m);
+        }
+    }
+    return count + compress_scalar(p + i, keep + i, n - i, out + count);
+}
+
+inline auto has_avx512() -> bool {
+    static bool const result = __builtin_cpu_supports("avx512f");
+    return result;
+}
+#endif
+
+template <typename T>
+inline auto compress(T const* p, bool const* keep, std::size_t n, T* out) -> std::size_t {
+#if RVR_SIMD_X86
+    if constexpr (sizeof(T) == 4 or sizeof(T) == 8) {
+        if (has_avx512()) {
+            return compress_avx512(p, keep, n, out);
+        } else if (has_avx2()) {
+            return compress_avx2(p, keep, n, out);
+        }
+    }
+#endif
+    return compress_scalar(p, keep, n, out);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// find_byte(p, n, c) and find_bytes(p, n, pattern, m): the index of the
+// first c, or of the first occurrence of the m bytes at pattern, in the n
+// bytes at p - or n if there isn't one. An empty pattern is never found.
+// A single byte is found with memchr, which is vectorized already. For
+// longer patterns, the AVX2 kernel compares 32 positions at a time against
+// both the first and the last byte of the pattern, and only compares the
+// rest of the pattern where both match. Otherwise, memchr finds the
+// candidates for the first byte.
+////////////////////////////////////////////////////////////////////////////
+inline auto find_byte(unsigned char const* p, std::size_t n, unsigned char c) -> std::size_t {
+    auto const hit = static_cast<unsigned char const*>(std::memchr(p, c, n));
+    return hit ? std::size_t(hit - p) : n;
+}
+
+inline auto find_bytes_scalar(unsigned char const* p, std::size_t n,
+                              unsigned char const* pattern, std::size_t m) -> std::size_t {
+    // only positions where the whole pattern fits are candidates
+    std::size_t i = 0;
+    while (i + m <= n) {
+        i += simd::find_byte(p + i, n - m + 1 - i, pattern[0]);
+        if (i + m > n) {
+            break;
+        }
+        if (std::memcmp(p + i + 1, pattern + 1, m - 1) == 0) {
+            return i;
+        }
+        ++i;
+    }
+    return n;
+}
+
+#if RVR_SIMD_X86
+[[gnu::target("avx2")]]
+inline auto find_bytes_avx2(unsigned char const* p, std::size_t n,
+                            unsigned char const* pattern, std::size_t m) -> std::size_t {
+    __m256i const first = _mm256_set1_epi8(char(pattern[0]));
+    __m256i const last = _mm256_set1_epi8(char(pattern[m - 1]));
+    std::size_t i = 0;
+    for (; i + m - 1 + 32 <= n; i += 32) {
+        __m256i const a = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p + i));
+        __m256i const b = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p + i + m - 1));
+        auto mask = std::uint32_t(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last))));
+        while (mask != 0) {
+            std::size_t const k = i + std::countr_zero(mask);
+            if (std::memcmp(p + k + 1, pattern + 1, m - 2) == 0) {
+                return k;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return i + find_bytes_scalar(p + i, n - i, pattern, m);
+}
+#endif
+
+inline auto find_bytes(unsigned char const* p, std::size_t n,
+                       unsigned char const* pattern, std::size_t m) -> std::size_t {
+    if (m == 0) {
+        return n;
+    } else if (m == 1) {
+        return simd::find_byte(p, n, pattern[0]);
+    }
+#if RVR_SIMD_X86
+    if (has_avx2()) {
+        return find_bytes_avx2(p, n, pattern, m);
+    }
+#endif
+    return find_bytes_scalar(p, n, pattern, m);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// find_in_class(p, n, rows): the index of the first of the n bytes at p
+// that is in the class given by rows (laid out as in rvr::char_class), or n.
+// A vector of bytes is classified with three shuffles (pshufb): one for each
+// half of rows, looked up by the low nibbles and picked between by the high
+// bit, and one that turns the high nibbles into the bit to test. That takes
+// SSSE3 (and SSE4.1 for the blend), and runs on 32 bytes at a time with
+// AVX2.
+////////////////////////////////////////////////////////////////////////////
+inline auto find_in_class_scalar(unsigned char const* p, std::size_t n,
+                                 std::uint8_t const* rows) -> std::size_t {
+    for (std::size_t i = 0; i != n; ++i) {
+        unsigned char const b = p[i];
+        if ((rows[(b >> 7) * 16 + (b & 15)] >> ((b >> 4) & 7)) & 1) {
+            return i;
+        }
+    }
+    return n;
+}
+
+#if RVR_SIMD_X86
+[[gnu::target("ssse3,sse4.1")]]
+inline auto find_in_class_sse4(unsigned char const* p, std::size_t n,
+                               std::uint8_t const* rows) -> std::size_t {
+    __m128i const low_rows = _mm_loadu_si128(reinterpret_cast<__m128i const*>(rows));
+    __m128i const high_rows = _mm_loadu_si128(reinterpret_cast<__m128i const*>(rows + 16));
+    __m128i const bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128,
+                                       1, 2, 4, 8, 16, 32, 64, -128);
+    __m128i const nibble = _mm_set1_epi8(0x0F);
+
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + i));
+        __m128i const lo = _mm_and_si128(v, nibble);
+        __m128i const hi = _mm_and_si128(_mm_srli_epi16(v, 4), nibble);
+        __m128i const row = _mm_blendv_epi8(_mm_shuffle_epi8(low_rows, lo),
+                                            _mm_shuffle_epi8(high_rows, lo), v);
+        __m128i const bit = _mm_shuffle_epi8(bits, hi);
+        auto const mask = unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(row, bit), bit)));
+        if (mask != 0) {
+            return i + std::countr_zero(mask);
+        }
+    }
+    return i + find_in_class_scalar(p + i, n - i, rows);
+}
+
+[[gnu::target("avx2")]]
+inline auto find_in_class_avx2(unsigned char const* p, std::size_t n,
+                               std::uint8_t const* rows) -> std::size_t {
+    // vpshufb looks up within each 16-byte lane, so the tables are repeated
+    __m256i const low_rows = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<__m128i const*>(rows)));
+    __m256i const high_rows = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<__m128i const*>(rows + 16)));
+    __m256i const bits = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128,
+                                          1, 2, 4, 8, 16, 32, 64, -128,
+                                          1, 2, 4, 8, 16, 32, 64, -128,
+                                          1, 2, 4, 8, 16, 32, 64, -128);
+    __m256i const nibble = _mm256_set1_epi8(0x0F);
+
+    std::size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i const v = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p + i));
+        __m256i const lo = _mm256_and_si256(v, nibble);
+        __m256i const hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble);
+        __m256i const row = _mm256_blendv_epi8(_mm256_shuffle_epi8(low_rows, lo),
+                                               _mm256_shuffle_epi8(high_rows, lo), v);
+        __m256i const bit = _mm256_shuffle_epi8(bits, hi);
+        auto const mask = std::uint32_t(_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_and_si256(row, bit), bit)));
+        if (mask != 0) {
+            return i + std::countr_zero(mask);
+        }
+    }
+    return i + find_in_class_sse4(p + i, n - i, rows);
+}
+
+inline auto has_sse4() -> bool {
+    static bool const result = __builtin_cpu_supports("sse4.1");
+    return result;
+}
+#endif
+
+inline auto find_in_class(unsigned char const* p, std::size_t n,
+                          std::uint8_t const* rows) -> std::size_t {
+#if RVR_SIMD_X86
+    if (has_avx2()) {
+        return find_in_class_avx2(p, n, rows);
+    } else if (has_sse4()) {
+        return find_in_class_sse4(p, n, rows);
+    }
+#endif
+    return find_in_class_scalar(p, n, rows);
+}
+
+////////////////////////////////////////////////////////////////////////////
+// csv_masks(p, separator, quote): for the 64 bytes at p, a bitmask of which
+// are quotes, which are separators, and which are '\n's - as in simdcsv.
+// This is called for every block, so rather than dispatching to AVX2 it
+// uses SSE2, which every x86-64 has and so can be inlined.
+// prefix_xor(x): bit i of the result is the xor of bits 0 through i of x.
+// Applied to the quote mask, that's which bytes are inside quotes.
+////////////////////////////////////////////////////////////////////////////
+struct csv_block {
+    std::uint64_t quote;
+    std::uint64_t separator;
+    std::uint64_t newline;
+};
+
+inline auto csv_masks(char const* p, char separator, char quote) -> csv_block {
+    csv_block masks = {0, 0, 0};
+#if RVR_SIMD_X86
+    __m128i const q = _mm_set1_epi8(quote);
+    __m128i const s = _mm_set1_epi8(separator);
+    __m128i const nl = _mm_set1_epi8('\n');
+    for (unsigned k = 0; k != 4; ++k) {
+        __m128i const v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + 16 * k));
+        masks.quote |= std::uint64_t(unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(v, q)))) << (16 * k);
+        masks.separator |= std::uint64_t(unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(v, s)))) << (16 * k);
+        masks.newline |= std::uint64_t(unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(v, nl)))) << (16 * k);
+    }
+#else
+    for (unsigned i = 0; i != 64; ++i) {
+        masks.quote |= std::uint64_t(p[i] == quote) << i;
+        masks.separator |= std::uint64_t(p[i] == separator) << i;
+        masks.newline |= std::uint64_t(p[i] == '\n') << i;
+    }
+#endif
+    return masks;
+}
+
+constexpr auto prefix_xor(std::uint64_t x) -> std::uint64_t {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+}
+
+#endif
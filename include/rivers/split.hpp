@@ -2,17 +2,97 @@
 #define RIVERS_SPLIT_HPP
 
 #include <rivers/core.hpp>
+#include <rivers/char_class.hpp>
 #include <rivers/ref.hpp>
+#include <algorithm>
+#include <span>
+#include <string_view>
+#include <vector>
 
 namespace rvr {
 
 ///////////////////////////////////////////////////////////////////////////
 // split: takes a (RiverOf<T> r, T v) and produces a new RiverOf<RiverOf<T>>
 // that is ... split... on ever instance of v
+// split can also take a contiguous range of T's (e.g. "\r\n"), and split on
+// every occurrence of that whole sequence - this requires r to be a
+// ContiguousRiver. A string literal's terminating '\0' isn't part of it.
+// When r is a ContiguousRiver, the delimiter is searched for in all of its
+// remaining elements at once (for bytes, with memchr or SIMD), rather than
+// compared against one element at a time.
 ////////////////////////////////////////////////////////////////////////////
 
-template <River R>
-struct Split : RiverBase<Split<R>>
+namespace detail {
+    // split's delimiter, when it's a sequence of elements
+    template <typename T>
+    struct split_pattern {
+        std::vector<T> elems;
+    };
+
+    template <typename T, typename P>
+    auto make_split_pattern(P const& p) -> split_pattern<T> {
+        auto const first = std::ranges::data(p);
+        std::size_t n = std::ranges::size(p);
+        if constexpr (std::is_array_v<P> and std::same_as<std::remove_cv_t<std::remove_extent_t<P>>, char>) {
+            if (n > 0 and first[n - 1] == '\0') {
+                --n;
+            }
+        }
+        return {std::vector<T>(first, first + n)};
+    }
+
+    template <typename T>
+    concept searchable_byte = sizeof(T) == 1
+                          and (std::integral<T> or std::same_as<T, std::byte>)
+                          and not std::same_as<T, bool>;
+
+    template <typename T>
+    auto as_bytes(T const* p) -> unsigned char const* {
+        return reinterpret_cast<unsigned char const*>(p);
+    }
+
+    // the index of the first delimiter in block, or block.size()
+    template <typename T>
+    auto find_delim(std::span<T const> block, T const& delim) -> std::size_t {
+        if constexpr (searchable_byte<T>) {
+            return simd::find_byte(as_bytes(block.data()), block.size(), static_cast<unsigned char>(delim));
+        } else {
+            return std::ranges::find(block, delim) - block.begin();
+        }
+    }
+
+    template <typename T>
+    auto find_delim(std::span<T const> block, split_pattern<T> const& delim) -> std::size_t {
+        if constexpr (searchable_byte<T>) {
+            return simd::find_bytes(as_bytes(block.data()), block.size(),
+                                    as_bytes(delim.elems.data()), delim.elems.size());
+        } else if (delim.elems.empty()) {
+            return block.size();
+        } else {
+            return std::ranges::search(block, delim.elems).begin() - block.begin();
+        }
+    }
+
+    template <searchable_byte T>
+    auto find_delim(std::span<T const> block, char_class const& delim) -> std::size_t {
+        return simd::find_in_class(as_bytes(block.data()), block.size(), delim.rows.data());
+    }
+
+    template <typename T>
+    constexpr auto delim_size(T const&) -> std::size_t {
+        return 1;
+    }
+
+    template <typename T>
+    constexpr auto delim_size(split_pattern<T> const& delim) -> std::size_t {
+        return delim.elems.size();
+    }
+}
+
+template <River R, typename D = value_t<R>>
+    requires std::same_as<D, value_t<R>>
+          or (std::same_as<D, detail::split_pattern<value_t<R>>> and ContiguousRiver<R>)
+struct Split : RiverBase<Split<R, D>>
 {
 private:
     struct Inner : RiverBase<Inner>
@@ -30,7 +110,7 @@ private:
     };
 
     R base;
-    value_t<R> delim;
+    D delim;
     bool exhausted = false;
     bool partial = false;
     Inner inner;
@@ -38,7 +118,7 @@ private:
 public:
     using reference = Ref<Inner>;
 
-    constexpr Split(R base, value_t<R> delim)
+    constexpr Split(R base, D delim)
         : base(std::move(base))
         , delim(std::move(delim))
         , inner(this)
@@ -77,34 +157,167 @@ public:
     }
 };
 
-template <River R>
-constexpr auto Split<R>::Inner::while_(PredicateFor<reference> auto&& pred) -> bool {
+template <River R, typename D>
+    requires std::same_as<D, value_t<R>>
+          or (std::same_as<D, detail::split_pattern<value_t<R>>> and ContiguousRiver<R>)
+constexpr auto Split<R, D>::Inner::while_(PredicateFor<reference> auto&& pred) -> bool {
     if (found_delim) {
         return true;
     }
 
-    bool result = parent->base.while_([&](reference elem){
-        if (elem == parent->delim) {
-            found_delim = true;
-            return false;
+    if constexpr (ContiguousRiver<R>) {
+        // find where this piece ends first, then hand out its elements
+        auto const rest = parent->base.remaining();
+        auto const n = detail::find_delim(std::span<value_t<R> const>(rest), parent->delim);
+        for (std::size_t i = 0; i != n; ++i) {
+            if (not std::invoke(pred, rest[i])) {
+                parent->base.advance(i + 1);
+                return false;
+            }
+        }
+
+        if (n == rest.size()) {
+            parent->base.advance(n);
+            parent->exhausted = true;
         } else {
-            return std::invoke(pred, elem);
+            parent->base.advance(n + detail::delim_size(parent->delim));
+            found_delim = true;
         }
-    });
+        return true;
+    } else {
+        bool const result = parent->base.while_([&](reference elem){
+            if (elem == parent->delim) {
+                found_delim = true;
+                return false;
+            } else {
+                return std::invoke(pred, elem);
+            }
+        });
 
-    if (result and not found_delim) {
-        parent->exhausted = true;
+        if (found_delim) {
+            return true;
+        } else if (result) {
+            parent->exhausted = true;
+        }
+        return result;
     }
-    return result;
 }
 
+///////////////////////////////////////////////////////////////////////////
+// split_views: like split, but only for ContiguousRivers, and each piece is
+// a view of the underlying elements rather than a river over them: a
+// std::basic_string_view for characters, a std::span<T const> otherwise.
+// The views point into wherever the river's elements live, so no piece is
+// ever copied - but they're only valid as long as those elements are.
+//
+// tokenize: takes a contiguous river of bytes and a char_class, and is
+// split_views on every byte in that class (e.g. any whitespace).
+////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+    template <typename T>
+    concept character = std::same_as<T, char>
+                     or std::same_as<T, wchar_t>
+                     or std::same_as<T, char8_t>
+                     or std::same_as<T, char16_t>
+                     or std::same_as<T, char32_t>;
+
+    template <typename T>
+    using split_view_t = std::conditional_t<character<T>,
+                                            std::basic_string_view<T>,
+                                            std::span<T const>>;
+}
+
+template <ContiguousRiver R, typename D = value_t<R>>
+    requires std::same_as<D, value_t<R>>
+          or std::same_as<D, detail::split_pattern<value_t<R>>>
+          or (std::same_as<D, char_class> and detail::searchable_byte<value_t<R>>)
+struct SplitViews : RiverBase<SplitViews<R, D>>
+{
+private:
+    R base;
+    D delim;
+    bool done = false;
+
+public:
+    using reference = detail::split_view_t<value_t<R>>;
+
+    constexpr SplitViews(R base, D delim)
+        : base(std::move(base))
+        , delim(std::move(delim))
+    { }
+
+    constexpr auto while_(PredicateFor<reference> auto&& pred) -> bool {
+        while (not done) {
+            auto const rest = std::span<value_t<R> const>(base.remaining());
+            auto const n = detail::find_delim(rest, delim);
+            auto const piece = reference(rest.data(), n);
+            if (n == rest.size()) {
+                base.advance(n);
+                done = true;
+            } else {
+                base.advance(n + detail::delim_size(delim));
+            }
+
+            if (not std::invoke(pred, piece)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // every piece but the first is preceded by a delimiter
+    constexpr auto size_hint() const -> SizeHint {
+        if (done) {
+            return SizeHint::exactly(0);
+        }
+        auto const n = base.remaining().size();
+        auto const d = std::max<std::size_t>(detail::delim_size(delim), 1);
+        return {.lower=1, .upper=n / d + 1};
+    }
+
+    void reset() requires ResettableRiver<R> {
+        base.reset();
+        done = false;
+    }
+};
+
 struct {
     template <River R>
     constexpr auto operator()(R&& r, value_t<R> delim) const {
         return Split(RVR_FWD(r), std::move(delim));
     }
+
+    template <River R, std::ranges::contiguous_range P>
+        requires ContiguousRiver<std::remove_cvref_t<R>>
+    constexpr auto operator()(R&& r, P const& pattern) const {
+        return Split(RVR_FWD(r), detail::make_split_pattern<value_t<R>>(pattern));
+    }
 } inline constexpr split;
 
+struct {
+    template <River R>
+        requires ContiguousRiver<std::remove_cvref_t<R>>
+    constexpr auto operator()(R&& r, value_t<R> delim) const {
+        return SplitViews(RVR_FWD(r), std::move(delim));
+    }
+
+    template <River R, std::ranges::contiguous_range P>
+        requires ContiguousRiver<std::remove_cvref_t<R>>
+    constexpr auto operator()(R&& r, P const& pattern) const {
+        return SplitViews(RVR_FWD(r), detail::make_split_pattern<value_t<R>>(pattern));
+    }
+} inline constexpr split_views;
+
+struct {
+    template <River R>
+        requires ContiguousRiver<std::remove_cvref_t<R>>
+             and detail::searchable_byte<value_t<R>>
+    constexpr auto operator()(R&& r, char_class const& delims) const {
+        return SplitViews(RVR_FWD(r), delims);
+    }
+} inline constexpr tokenize;
+
 template <typename Derived>
 template <typename D>
 constexpr auto RiverBase<Derived>::split(value_t<D> delim) & {
@@ -114,9 +327,66 @@ constexpr auto RiverBase<Derived>::split(value_t<D> delim) & {
 template <typename Derived>
 template <typename D>
 constexpr auto RiverBase<Derived>::split(value_t<D> delim) && {
-    return Split(RVR_FWD(self()), std::move(delim));
+    return Split(std::move(self()), std::move(delim));
 }
 
+template <typename Derived>
+template <typename D, std::ranges::contiguous_range P>
+constexpr auto RiverBase<Derived>::split(P const& pattern) & {
+    static_assert(ContiguousRiver<D>, "splitting on a sequence requires a contiguous river");
+    return Split(self(), detail::make_split_pattern<value_t<D>>(pattern));
+}
+
+template <typename Derived>
+template <typename D, std::ranges::contiguous_range P>
+constexpr auto RiverBase<Derived>::split(P const& pattern) && {
+    static_assert(ContiguousRiver<D>, "splitting on a sequence requires a contiguous river");
+    return Split(std::move(self()), detail::make_split_pattern<value_t<D>>(pattern));
+}
+
+template <typename Derived>
+template <typename D>
+constexpr auto RiverBase<Derived>::split_views(value_t<D> delim) & {
+    static_assert(ContiguousRiver<D>, "split_views requires a contiguous river");
+    return SplitViews(self(), std::move(delim));
+}
+
+template <typename Derived>
+template <typename D>
+constexpr auto RiverBase<Derived>::split_views(value_t<D> delim) && {
+    static_assert(ContiguousRiver<D>, "split_views requires a contiguous river");
+    return SplitViews(std::move(self()), std::move(delim));
+}
+
+template <typename Derived>
+template <typename D, std::ranges::contiguous_range P>
+constexpr auto RiverBase<Derived>::split_views(P const& pattern) & {
+    static_assert(ContiguousRiver<D>, "split_views requires a contiguous river");
+    return SplitViews(self(), detail::make_split_pattern<value_t<D>>(pattern));
+}
+
+template <typename Derived>
+template <typename D, std::ranges::contiguous_range P>
+constexpr auto RiverBase<Derived>::split_views(P const& pattern) && {
+    static_assert(ContiguousRiver<D>, "split_views requires a contiguous river");
+    return SplitViews(std::move(self()), detail::make_split_pattern<value_t<D>>(pattern));
+}
+
+template <typename Derived>
+template <typename D>
+constexpr auto RiverBase<Derived>::tokenize(char_class const& delims) & {
+    static_assert(ContiguousRiver<D> and detail::searchable_byte<value_t<D>>,
+                  "tokenize requires a contiguous river of bytes");
+    return SplitViews(self(), delims);
+}
+
+template <typename Derived>
+template <typename D>
+constexpr auto RiverBase<Derived>::tokenize(char_class const& delims) && {
+    static_assert(ContiguousRiver<D> and detail::searchable_byte<value_t<D>>,
+                  "tokenize requires a contiguous river of bytes");
+    return SplitViews(std::move(self()), delims);
+}
 
 }
 
@@ -0,0 +1,116 @@
+#ifndef RIVERS_STOP_HPP
+#define RIVERS_STOP_HPP
+
+#include <rivers/core.hpp>
+#include <stop_token>
+
+namespace rvr {
+
+////////////////////////////////////////////////////////////////////////////
+// stop_source and stop_token are std's, so that, say, a std::jthread's
+// token can be used too.
+//
+// until_stopped: takes a (RiverOf<T>, stop_token) and produces a RiverOf<T>
+// with the same elements, except that it ends once a stop is requested -
+// so that another thread can cancel a long for_each. The token is checked
+// between batches: before every chunk, or every chunk_size elements.
+// Splitting it splits the underlying river, with every piece checking the
+// same token, so it stays parallel under par.
+////////////////////////////////////////////////////////////////////////////
+
+using stop_source = std::stop_source;
+using stop_token = std::stop_token;
+
+namespace detail {
+    struct token_stopped {
+        stop_token token;
+
+        auto operator()() const -> bool {
+            return token.stop_requested();
+        }
+    };
+}
+
+// Stopped is what's checked: a function that returns whether to stop, and
+// once it has returned true, has to keep doing so. Parallel algorithms use
+// this to stop their pieces on conditions of their own.
+template <River R, std::predicate Stopped>
+struct UntilStopped : RiverBase<UntilStopped<R, Stopped>>
+{
+private:
+    R base;
+    Stopped stopped;
+
+public:
+    using reference = reference_t<R>;
+
+    constexpr UntilStopped(R base, Stopped stopped)
+        : base(std::move(base))
+        , stopped(std::move(stopped))
+    { }
+
+    constexpr auto while_(PredicateFor<reference> auto&& pred) -> bool {
+        if (stopped()) {
+            return true;
+        }
+
+        std::size_t until_check = chunk_size;
+        bool stopping = false;
+        bool const done = base.while_([&](reference_t<R> elem){
+            if (not std::invoke(pred, RVR_FWD(elem))) {
+                return false;
+            }
+            if (--until_check == 0) {
+                until_check = chunk_size;
+                stopping = stopped();
+                return not stopping;
+            }
+            return true;
+        });
+        return done or stopping;
+    }
+
+    constexpr auto while_chunk(PredicateFor<chunk_t<UntilStopped>> auto&& pred) -> bool
+        requires ChunkedRiver<R>
+    {
+        bool stopping = false;
+        bool const done = base.while_chunk([&](chunk_t<R> chunk){
+            stopping = stopped();
+            return not stopping and std::invoke(pred, chunk);
+        });
+        return done or stopping;
+    }
+
+    constexpr auto size_hint() const -> SizeHint {
+        return {.lower=0, .upper=rvr::size_hint(base).upper};
+    }
+
+    constexpr auto try_split() requires SplittableRiver<R>
+                                    and std::copy_constructible<Stopped>
+    {
+        return base.try_split().map([&](split_t<R>&& prefix){
+            return UntilStopped<split_t<R>, Stopped>(std::move(prefix), stopped);
+        });
+    }
+};
+
+struct {
+    template <River R>
+    constexpr auto operator()(R&& r, stop_token token) const {
+        return UntilStopped(RVR_FWD(r), detail::token_stopped{std::move(token)});
+    }
+} inline constexpr until_stopped;
+
+template <typename Derived>
+auto RiverBase<Derived>::until_stopped(stop_token token) & {
+    return UntilStopped(self(), detail::token_stopped{std::move(token)});
+}
+
+template <typename Derived>
+auto RiverBase<Derived>::until_stopped(stop_token token) && {
+    return UntilStopped(std::move(self()), detail::token_stopped{std::move(token)});
+}
+
+}
+
+#endif
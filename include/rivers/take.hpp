@@ -1,6 +1,7 @@
 #ifndef RIVERS_TAKE_HPP
 #define RIVERS_TAKE_HPP
 
+#include <algorithm>
 #include <rivers/core.hpp>
 
 namespace rvr {
@@ -34,6 +35,78 @@ public:
         }
     }
 
+    // We can only forward our base's blocks while there are at least
+    // chunk_size elements left to take, since any block could be that large
+    // and we must not consume more than n elements. The remaining tail is
+    // handed off one element at a time.
+    constexpr auto while_chunk(PredicateFor<chunk_t<Take>> auto&& pred) -> bool
+        requires ChunkedRiver<R>
+    {
+        if (n - i >= int(chunk_size)) {
+            bool stopped = false;
+            bool const exhausted = base.while_chunk([&](chunk_t<R> chunk){
+                i += chunk.size();
+                if (not std::invoke(pred, chunk)) {
+                    stopped = true;
+                    return false;
+                }
+                return n - i >= int(chunk_size);
+            });
+            if (exhausted or stopped) {
+                return not stopped;
+            }
+        }
+
+        return while_([&](reference elem){
+            value_t<Take> const value = RVR_FWD(elem);
+            return std::invoke(pred, chunk_t<Take>(&value, 1));
+        });
+    }
+
+    constexpr auto size_hint() const -> SizeHint {
+        auto const remaining = std::size_t(n - i);
+        auto const hint = rvr::size_hint(base);
+        return {.lower=std::min(hint.lower, remaining),
+                .upper=std::min(hint.upper.value_or(remaining), remaining)};
+    }
+
+    constexpr auto advance(std::size_t k) -> std::size_t
+        requires AdvanceableRiver<R>
+    {
+        auto const skipped = base.advance(std::min(k, std::size_t(n - i)));
+        i += int(skipped);
+        return skipped;
+    }
+
+    constexpr auto remaining() const requires ContiguousRiver<R> {
+        auto const all = base.remaining();
+        return all.first(std::min<std::size_t>(all.size(), n - i));
+    }
+
+    // We can only split when we know exactly how many elements our base has
+    // left, so that we know how many of them belong to each piece
+    constexpr auto try_split() requires SplittableRiver<R>
+    {
+        using Prefix = Take<split_t<R>>;
+
+        auto const total = rvr::size_hint(base).exact();
+        if (not total or i == n) {
+            return tl::optional<Prefix>();
+        }
+
+        auto piece = base.try_split();
+        if (not piece) {
+            return tl::optional<Prefix>();
+        }
+
+        // the prefix gets whichever of the remaining elements it has
+        auto const in_prefix = int(std::min<std::size_t>(
+            *total - rvr::size_hint(base).lower,
+            std::size_t(n - i)));
+        n -= in_prefix;
+        return tl::optional<Prefix>(Prefix(std::move(*piece), in_prefix));
+    }
+
     void reset() requires ResettableRiver<R>
     {
         base.reset();
@@ -55,7 +128,7 @@ constexpr auto RiverBase<Derived>::take(int n) & {
 
 template <typename Derived>
 constexpr auto RiverBase<Derived>::take(int n) && {
-    return Take(RVR_FWD(self()), n);
+    return Take(std::move(self()), n);
 }
 
 }
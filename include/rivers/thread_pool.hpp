@@ -0,0 +1,378 @@
+#ifndef RIVERS_THREAD_POOL_HPP
+#define RIVERS_THREAD_POOL_HPP
+
+#include <rivers/core.hpp>
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace rvr {
+
+////////////////////////////////////////////////////////////////////////////
+// An executor is something that can run tasks asynchronously:
+// * e.execute(f) runs f() at some point, on some thread. f must not throw.
+// * e.concurrency() is how many tasks it can usefully run at once
+// An executor can additionally provide e.try_run_one(), which runs one
+// pending task on the calling thread (returning whether there was one).
+// Callers waiting on their tasks use this to help, rather than block.
+////////////////////////////////////////////////////////////////////////////
+template <typename E>
+concept executor = requires (E& e, void (*f)()) {
+        e.execute(f);
+        { e.concurrency() } -> std::convertible_to<std::size_t>;
+    };
+
+namespace detail {
+    struct task {
+        // runs the task, and then destroys it
+        void (*run)(task*);
+    };
+
+    template <typename F>
+    struct task_for : task {
+        F f;
+
+        explicit task_for(F f) : task{.run=&task_for::invoke}, f(std::move(f)) { }
+
+        static void invoke(task* t) {
+            std::unique_ptr<task_for> self(static_cast<task_for*>(t));
+            self->f();
+        }
+    };
+
+    ////////////////////////////////////////////////////////////////////////
+    // Chase-Lev work-stealing deque, as in "Correct and Efficient
+    // Work-Stealing for Weak Memory Models" (Lê et al., 2013).
+    // The owning thread pushes and pops at the bottom, while any thread can
+    // steal from the top. Arrays that have been outgrown are kept alive
+    // until the deque is destroyed, since a thief may still be reading one.
+    ////////////////////////////////////////////////////////////////////////
+    class work_stealing_deque {
+        struct ring {
+            std::int64_t capacity;
+            std::unique_ptr<std::atomic<task*>[]> slots;
+
+            explicit ring(std::int64_t capacity)
+                : capacity(capacity)
+                , slots(new std::atomic<task*>[capacity])
+            { }
+
+            auto get(std::int64_t i) const -> task* {
+                return slots[i & (capacity - 1)].load(std::memory_order_relaxed);
+            }
+
+            void put(std::int64_t i, task* t) {
+                slots[i & (capacity - 1)].store(t, std::memory_order_relaxed);
+            }
+
+            auto grow(std::int64_t top, std::int64_t bottom) const -> std::unique_ptr<ring> {
+                auto bigger = std::make_unique<ring>(capacity * 2);
+                for (std::int64_t i = top; i != bottom; ++i) {
+                    bigger->put(i, get(i));
+                }
+                return bigger;
+            }
+        };
+
+        alignas(64) std::atomic<std::int64_t> top{0};
+        alignas(64) std::atomic<std::int64_t> bottom{0};
+        std::atomic<ring*> array;
+        std::vector<std::unique_ptr<ring>> rings;
+
+    public:
+        work_stealing_deque() {
+            rings.push_back(std::make_unique<ring>(64));
+            array.store(rings.back().get(), std::memory_order_relaxed);
+        }
+
+        // only called by the owner
+        void push(task* t) {
+            std::int64_t const b = bottom.load(std::memory_order_relaxed);
+            std::int64_t const tp = top.load(std::memory_order_acquire);
+            ring* a = array.load(std::memory_order_relaxed);
+            if (b - tp > a->capacity - 1) {
+                rings.push_back(a->grow(tp, b));
+                a = rings.back().get();
+                array.store(a, std::memory_order_release);
+            }
+            a->put(b, t);
+            std::atomic_thread_fence(std::memory_order_release);
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+
+        // only called by the owner
+        auto pop() -> task* {
+            std::int64_t const b = bottom.load(std::memory_order_relaxed) - 1;
+            ring* a = array.load(std::memory_order_relaxed);
+            bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            std::int64_t t = top.load(std::memory_order_relaxed);
+
+            if (t > b) {
+                // was empty
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            task* x = a->get(b);
+            if (t == b) {
+                // the last element, race against the thieves for it
+                if (not top.compare_exchange_strong(t, t + 1,
+                        std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    x = nullptr;
+                }
+                bottom.store(b + 1, std::memory_order_relaxed);
+            }
+            return x;
+        }
+
+        // can be called from any thread. Returns nullptr if the deque was
+        // empty or if we lost a race for the top element
+        auto steal() -> task* {
+            std::int64_t t = top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            std::int64_t const b = bottom.load(std::memory_order_acquire);
+            if (t >= b) {
+                return nullptr;
+            }
+
+            ring* a = array.load(std::memory_order_acquire);
+            task* x = a->get(t);
+            if (not top.compare_exchange_strong(t, t + 1,
+                    std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return nullptr;
+            }
+            return x;
+        }
+    };
+}
+
+////////////////////////////////////////////////////////////////////////////
+// thread_pool: a work-stealing executor.
+// Every worker has its own deque: tasks submitted from a worker go to the
+// bottom of its own deque (and are popped from there, LIFO), while idle
+// workers steal from the top of others'. Tasks submitted from other
+// threads go through a shared queue. Idle workers sleep until new tasks
+// are submitted. Optionally, worker i can be pinned to CPU i.
+////////////////////////////////////////////////////////////////////////////
+class thread_pool {
+    struct worker {
+        detail::work_stealing_deque deque;
+        std::jthread thread;
+    };
+
+    std::vector<std::unique_ptr<worker>> workers;
+    std::mutex injection_mutex;
+    std::deque<detail::task*> injection;
+    std::atomic<std::size_t> injected{0};
+
+    std::atomic<std::uint32_t> epoch{0};
+    std::atomic<int> sleeping{0};
+    std::atomic<bool> stopping{false};
+
+    static inline thread_local thread_pool* current_pool = nullptr;
+    static inline thread_local std::size_t current_index = 0;
+
+    auto pop_injected() -> detail::task* {
+        if (injected.load(std::memory_order_relaxed) == 0) {
+            return nullptr;
+        }
+
+        std::scoped_lock lock(injection_mutex);
+        if (injection.empty()) {
+            return nullptr;
+        }
+        detail::task* t = injection.front();
+        injection.pop_front();
+        injected.fetch_sub(1, std::memory_order_relaxed);
+        return t;
+    }
+
+    auto find_work() -> detail::task* {
+        bool const on_worker = (current_pool == this);
+        if (on_worker) {
+            if (detail::task* t = workers[current_index]->deque.pop()) {
+                return t;
+            }
+        }
+
+        if (detail::task* t = pop_injected()) {
+            return t;
+        }
+
+        std::size_t const n = workers.size();
+        std::size_t const start = on_worker ? current_index + 1 : 0;
+        for (std::size_t i = 0; i != n; ++i) {
+            std::size_t const victim = (start + i) % n;
+            if (on_worker and victim == current_index) {
+                continue;
+            }
+            if (detail::task* t = workers[victim]->deque.steal()) {
+                return t;
+            }
+        }
+        return nullptr;
+    }
+
+    static void pin_to_cpu([[maybe_unused]] std::size_t cpu) {
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu % CPU_SETSIZE, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+    }
+
+    void work(std::size_t index, bool pin) {
+        current_pool = this;
+        current_index = index;
+        if (pin) {
+            pin_to_cpu(index);
+        }
+
+        for (;;) {
+            if (detail::task* t = find_work()) {
+                t->run(t);
+                continue;
+            }
+
+            // Announce that we're going to sleep, and look one more time.
+            // Any task submitted after we read epoch will change it, so we
+            // can't miss a wakeup.
+            auto const seen = epoch.load(std::memory_order_seq_cst);
+            sleeping.fetch_add(1, std::memory_order_seq_cst);
+            if (detail::task* t = find_work()) {
+                sleeping.fetch_sub(1, std::memory_order_relaxed);
+                t->run(t);
+                continue;
+            }
+
+            if (stopping.load(std::memory_order_acquire)) {
+                sleeping.fetch_sub(1, std::memory_order_relaxed);
+                return;
+            }
+
+            epoch.wait(seen, std::memory_order_seq_cst);
+            sleeping.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    void wake_one() {
+        epoch.fetch_add(1, std::memory_order_seq_cst);
+        if (sleeping.load(std::memory_order_seq_cst) > 0) {
+            epoch.notify_one();
+        }
+    }
+
+public:
+    explicit thread_pool(std::size_t threads = std::thread::hardware_concurrency(),
+                         bool pin_threads = false)
+    {
+        threads = std::max<std::size_t>(threads, 1);
+        workers.reserve(threads);
+        for (std::size_t i = 0; i != threads; ++i) {
+            workers.push_back(std::make_unique<worker>());
+        }
+        for (std::size_t i = 0; i != threads; ++i) {
+            workers[i]->thread = std::jthread([=, this]{ work(i, pin_threads); });
+        }
+    }
+
+    thread_pool(thread_pool const&) = delete;
+    auto operator=(thread_pool const&) -> thread_pool& = delete;
+
+    // finishes all the pending tasks before returning
+    ~thread_pool() {
+        stopping.store(true, std::memory_order_release);
+        epoch.fetch_add(1, std::memory_order_seq_cst);
+        epoch.notify_all();
+        for (auto& w : workers) {
+            w->thread.join();
+        }
+    }
+
+    template <std::invocable F>
+    void execute(F&& f) {
+        detail::task* t = new detail::task_for<std::decay_t<F>>(RVR_FWD(f));
+        if (current_pool == this) {
+            workers[current_index]->deque.push(t);
+        } else {
+            std::scoped_lock lock(injection_mutex);
+            injection.push_back(t);
+            injected.fetch_add(1, std::memory_order_relaxed);
+        }
+        wake_one();
+    }
+
+    auto try_run_one() -> bool {
+        if (detail::task* t = find_work()) {
+            t->run(t);
+            return true;
+        }
+        return false;
+    }
+
+    auto concurrency() const -> std::size_t {
+        return workers.size();
+    }
+};
+
+// The pool used by parallel algorithms when no executor is given. It is
+// created on first use, with one worker per hardware thread.
+inline auto default_pool() -> thread_pool& {
+    static thread_pool pool;
+    return pool;
+}
+
+namespace detail {
+    // Runs f(0), ..., f(n-1) - the last on the calling thread, the rest on
+    // exec - and waits for all of them to finish. f must not throw. While
+    // waiting, the calling thread helps run other tasks if it can.
+    template <executor E, typename F>
+    void fork_join(E& exec, std::size_t n, F& f) {
+        if (n == 0) {
+            return;
+        }
+
+        // shared, since the last task to finish may still be notifying
+        // after the waiter has seen the count drop to zero
+        auto remaining = std::make_shared<std::atomic<std::size_t>>(n - 1);
+        for (std::size_t i = 0; i != n - 1; ++i) {
+            exec.execute([&f, i, remaining]{
+                f(i);
+                if (remaining->fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    remaining->notify_all();
+                }
+            });
+        }
+        f(n - 1);
+
+        for (;;) {
+            std::size_t const left = remaining->load(std::memory_order_acquire);
+            if (left == 0) {
+                break;
+            }
+            if constexpr (requires { { exec.try_run_one() } -> std::same_as<bool>; }) {
+                if (exec.try_run_one()) {
+                    continue;
+                }
+            }
+            remaining->wait(left, std::memory_order_acquire);
+        }
+    }
+}
+
+}
+
+#endif
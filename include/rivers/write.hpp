@@ -0,0 +1,245 @@
+#ifndef RIVERS_WRITE_HPP
+#define RIVERS_WRITE_HPP
+
+#if __has_include(<unistd.h>)
+#include <rivers/core.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <climits>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace rvr {
+
+////////////////////////////////////////////////////////////////////////////
+// Terminals that write a river out to a file
+// * write_to(r, fd) writes each element of r to the file descriptor fd:
+//   the characters of anything convertible to a std::string_view, the
+//   bytes of a contiguous range (like a std::span<std::byte const>), and
+//   otherwise the bytes of the element itself, which has to be trivially
+//   copyable
+// * write_lines(r, fd, separator = "\n") writes each element of r to fd
+//   followed by separator - strings as they are, and numbers in decimal
+// * write_records(r, path) writes the elements of r, which have to be
+//   trivially copyable, to the file at path as a flat array of their bytes,
+//   replacing whatever was there. Reading the file back with
+//   from_records<value_t<R>>(path) gives the same elements.
+// Each returns how many elements it wrote. Neither write_to nor write_lines
+// owns or closes fd.
+// Writes go through a large buffer, except for big elements (like whole
+// blocks of a file), which go straight out in one writev along with what
+// was buffered before them, without being copied. Errors are thrown as
+// std::system_error.
+////////////////////////////////////////////////////////////////////////////
+
+namespace detail {
+    // writes all of iov[0, count), for however many calls that takes
+    inline void write_fully(int fd, ::iovec* iov, std::size_t count) {
+        while (count != 0) {
+            auto const written = ::writev(fd, iov, int(std::min<std::size_t>(count, IOV_MAX)));
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw std::system_error(errno, std::generic_category(), "rivers: could not write");
+            }
+            auto n = std::size_t(written);
+            for (; count != 0 and n >= iov->iov_len; ++iov, --count) {
+                n -= iov->iov_len;
+            }
+            if (count != 0) {
+                iov->iov_base = static_cast<char*>(iov->iov_base) + n;
+                iov->iov_len -= n;
+            }
+        }
+    }
+
+    // Buffers writes to a file descriptor (which it doesn't own). Writes of
+    // at least capacity / 16 bytes aren't copied, and instead go out in a
+    // single writev along with whatever was buffered before them.
+    class fd_writer {
+        int fd;
+        std::size_t capacity;
+        std::unique_ptr<std::byte[]> buffer;
+        std::size_t used = 0;
+
+    public:
+        explicit fd_writer(int fd, std::size_t capacity = std::size_t(1) << 20)
+            : fd(fd)
+            , capacity(capacity)
+            , buffer(std::make_unique<std::byte[]>(capacity))
+        { }
+
+        void write(void const* data, std::size_t n) {
+            if (n >= capacity / 16) {
+                ::iovec iov[] = {{buffer.get(), used}, {const_cast<void*>(data), n}};
+                write_fully(fd, iov, 2);
+                used = 0;
+                return;
+            }
+            if (n > capacity - used) {
+                flush();
+            }
+            std::memcpy(buffer.get() + used, data, n);
+            used += n;
+        }
+
+        void write(std::string_view s) {
+            write(s.data(), s.size());
+        }
+
+        // writes value in decimal (or the shortest representation that
+        // round trips, for floating-point)
+        template <typename T>
+            requires (std::is_arithmetic_v<T> and not std::same_as<T, bool>)
+        void write_number(T value) {
+            char digits[64];
+            auto const [end, ec] = std::to_chars(digits, std::end(digits), value);
+            write(digits, std::size_t(end - digits));
+        }
+
+        void flush() {
+            ::iovec iov = {buffer.get(), used};
+            write_fully(fd, &iov, 1);
+            used = 0;
+        }
+    };
+
+    template <typename T>
+    concept byte_range = std::ranges::contiguous_range<T> and std::ranges::sized_range<T>
+        and std::is_trivially_copyable_v<std::ranges::range_value_t<T>>;
+
+    // writes the bytes of each element of r, a chunk at a time if it's
+    // chunked, returning how many there were
+    template <River R>
+    auto write_values(R& r, fd_writer& writer) -> std::size_t {
+        std::size_t count = 0;
+        if constexpr (ChunkedRiver<R>) {
+            r.while_chunk([&](chunk_t<R> chunk){
+                writer.write(chunk.data(), chunk.size_bytes());
+                count += chunk.size();
+                return true;
+            });
+        } else {
+            r.for_each([&](reference_t<R> elem){
+                value_t<R> const value = RVR_FWD(elem);
+                writer.write(&value, sizeof(value));
+                ++count;
+            });
+        }
+        return count;
+    }
+
+    // a file opened for writing, closed on scope exit
+    class output_file {
+        int fd_;
+
+    public:
+        explicit output_file(std::filesystem::path const& path)
+            : fd_(::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666))
+        {
+            if (fd_ < 0) {
+                throw std::system_error(errno, std::generic_category(),
+                                        "rivers: could not open " + path.string());
+            }
+        }
+
+        output_file(output_file const&) = delete;
+        auto operator=(output_file const&) -> output_file& = delete;
+
+        ~output_file() {
+            if (fd_ >= 0) {
+                ::close(fd_);
+            }
+        }
+
+        auto fd() const -> int { return fd_; }
+
+        void close() {
+            if (::close(std::exchange(fd_, -1)) != 0) {
+                throw std::system_error(errno, std::generic_category(), "rivers: could not close");
+            }
+        }
+    };
+}
+
+struct {
+    template <River R>
+        requires std::is_trivially_copyable_v<value_t<R>>
+    auto operator()(R&& r, std::filesystem::path const& path) const -> std::size_t {
+        detail::output_file file(path);
+        detail::fd_writer writer(file.fd());
+        auto const count = detail::write_values(r, writer);
+        writer.flush();
+        file.close();
+        return count;
+    }
+} inline constexpr write_records;
+
+struct {
+    template <River R>
+        requires std::convertible_to<reference_t<R>, std::string_view>
+              or detail::byte_range<reference_t<R>>
+              or std::is_trivially_copyable_v<value_t<R>>
+    auto operator()(R&& r, int fd) const -> std::size_t {
+        detail::fd_writer writer(fd);
+        std::size_t count = 0;
+        if constexpr (std::convertible_to<reference_t<R>, std::string_view>) {
+            r.for_each([&](reference_t<R> elem){
+                writer.write(std::string_view(RVR_FWD(elem)));
+                ++count;
+            });
+        } else if constexpr (detail::byte_range<reference_t<R>>) {
+            r.for_each([&](reference_t<R> elem){
+                auto const bytes = std::as_bytes(std::span(elem));
+                writer.write(bytes.data(), bytes.size());
+                ++count;
+            });
+        } else {
+            count = detail::write_values(r, writer);
+        }
+        writer.flush();
+        return count;
+    }
+} inline constexpr write_to;
+
+struct {
+    template <River R>
+        requires std::convertible_to<reference_t<R>, std::string_view>
+              or (std::is_arithmetic_v<value_t<R>> and not std::same_as<value_t<R>, bool>)
+    auto operator()(R&& r, int fd, std::string_view separator = "\n") const -> std::size_t {
+        detail::fd_writer writer(fd);
+        std::size_t count = 0;
+        r.for_each([&](reference_t<R> elem){
+            if constexpr (std::convertible_to<reference_t<R>, std::string_view>) {
+                writer.write(std::string_view(RVR_FWD(elem)));
+            } else {
+                writer.write_number(value_t<R>(elem));
+            }
+            writer.write(separator);
+            ++count;
+        });
+        writer.flush();
+        return count;
+    }
+} inline constexpr write_lines;
+
+}
+
+#endif
+
+#endif
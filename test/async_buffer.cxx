@@ -0,0 +1,91 @@
+#include "catch.hpp"
+
+#include <atomic>
+#include <climits>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <rivers/rivers.hpp>
+#include "test_utils.hpp"
+
+TEST_CASE("async_buffer", "[async_buffer]") {
+    auto const n = GENERATE(1, 2, 16, 1024);
+
+    auto r = rvr::seq(10'000).async_buffer(n);
+    STATIC_REQUIRE(std::same_as<rvr::reference_t<decltype(r)>, int>);
+    CHECK(r.next() == Some(0));
+    CHECK(r.next() == Some(1));
+    CHECK(r.ref().take(3).into_vec() == std::vector{2, 3, 4});
+    CHECK(r.sum() == 10'000 * 9'999 / 2 - 10);
+    CHECK_FALSE(r.next());
+
+    CHECK(rvr::seq(10'000).async_buffer(n).into_vec() == rvr::seq(10'000).into_vec());
+    CHECK(rvr::seq(0).async_buffer(n).count() == 0);
+}
+
+TEST_CASE("async_buffer runs upstream on another thread", "[async_buffer]") {
+    auto const consumer = std::this_thread::get_id();
+    CHECK(rvr::seq(1000)
+        .map([&](int i){ return std::this_thread::get_id() != consumer ? i : -1; })
+        .async_buffer(8)
+        .map([&](int i){ return std::this_thread::get_id() == consumer ? i : -1; })
+        .all([](int i){ return i >= 0; }));
+
+    // move-only elements are moved across
+    auto owned = rvr::seq(100)
+        .map([](int i){ return std::make_unique<int>(i); })
+        .async_buffer(4)
+        .map([](std::unique_ptr<int> p){ return *p; });
+    CHECK(owned.sum() == 4950);
+
+    // never started
+    auto unused = rvr::seq(10).async_buffer();
+}
+
+TEST_CASE("async_buffer hands over every element", "[async_buffer]") {
+    // upstream doesn't produce the next element until this one has been
+    // consumed, so the consumer has to be woken for each of them
+    std::atomic<int> consumed = 0;
+    auto r = rvr::seq(2000)
+        .map([&](int i){
+            while (consumed.load() != i) {
+                std::this_thread::yield();
+            }
+            return i;
+        })
+        .async_buffer(1024);
+    CHECK(r.all([&](int i){
+        consumed.store(i + 1);
+        return true;
+    }));
+    CHECK(consumed.load() == 2000);
+}
+
+TEST_CASE("async_buffer stops upstream early", "[async_buffer]") {
+    std::atomic<int> produced = 0;
+    {
+        auto r = rvr::seq(INT_MAX)
+            .map([&](int i){ ++produced; return i; })
+            .async_buffer(8);
+        CHECK(r.any([](int i){ return i == 100; }));
+    }
+    // the producer can only have got one ring's worth ahead
+    CHECK(produced.load() <= 101 + 8 + 1);
+}
+
+TEST_CASE("async_buffer rethrows", "[async_buffer]") {
+    auto r = rvr::seq(1000)
+        .map([](int i){
+            if (i == 50) {
+                throw std::runtime_error("upstream");
+            }
+            return i;
+        })
+        .async_buffer(16);
+
+    std::vector<int> seen;
+    CHECK_THROWS_AS(r.for_each([&](int i){ seen.push_back(i); }), std::runtime_error);
+    CHECK(seen == rvr::seq(50).into_vec());
+    CHECK_FALSE(r.next());
+}
@@ -1,6 +1,8 @@
 #include "catch.hpp"
 
 #include <list>
+#include <memory>
+#include <numeric>
 #include <vector>
 #include <sstream>
 #include <rivers/rivers.hpp>
@@ -48,6 +50,47 @@ TEST_CASE("seq") {
     CHECK(s == 4950);
 }
 
+TEST_CASE("seq with step") {
+    CHECK(rvr::seq(0, 10, 3).into_vec() == std::vector{0, 3, 6, 9});
+    CHECK(rvr::seq(5, 0, -2).into_vec() == std::vector{5, 3, 1});
+    CHECK(rvr::seq(0, 10, 20).into_vec() == std::vector{0});
+    CHECK(rvr::seq(10, 0, 1).into_vec().empty());
+    CHECK(rvr::seq(1, 0).into_vec().empty());
+
+    // the last element is right at the edge of the type
+    CHECK(rvr::Seq<signed char>(100, 127, 13).into_vec() == std::vector<signed char>{100, 113, 126});
+    CHECK(rvr::Seq<unsigned>(10, 0, -5).into_vec() == std::vector<unsigned>{10, 5});
+
+    // closed forms
+    CHECK(rvr::seq(0, 10, 3).sum() == 18);
+    CHECK(rvr::seq(5, 0, -2).sum() == 9);
+    CHECK(rvr::seq(0, 10, 3).sum(100) == 118);
+    CHECK(rvr::seq(1LL, 3'000'000'001LL).sum() == 4'500'000'001'500'000'000LL);
+    CHECK(rvr::seq(0LL, 3'000'000'000LL, 7LL).count() == 428'571'429);
+    CHECK(rvr::seq(5, 0, -2).count() == 3);
+    STATIC_REQUIRE(rvr::seq(1, 101).sum() == 5050);
+
+    auto r = rvr::seq(0, 100, 10);
+    CHECK(rvr::size_hint(r).exact() == 10u);
+    CHECK(r.next() == Some(0));
+    CHECK(r.sum() == 450);
+    CHECK(rvr::size_hint(r).exact() == 0u);
+    CHECK_FALSE(r.next());
+
+    // drop and take stay seqs
+    auto middle = rvr::seq(0, 100, 10).drop(2).take(3);
+    STATIC_REQUIRE(std::same_as<decltype(middle), rvr::Seq<int>>);
+    CHECK(middle.into_vec() == std::vector{20, 30, 40});
+    middle.reset();
+    CHECK(middle.sum() == 90);
+    CHECK(rvr::seq(10).drop(20).into_vec().empty());
+    CHECK(rvr::seq(10).take(-1).into_vec().empty());
+
+    // non-integers still just loop
+    int arr[] = {1, 2, 3};
+    CHECK(rvr::seq(arr + 0, arr + 3).count() == 3);
+}
+
 TEST_CASE("vector") {
     std::vector v = {1, 2, 3};
     auto r = rvr::from(v);
@@ -124,6 +167,15 @@ TEST_CASE("filter") {
     CHECK(evens.sum() == 2450);
 }
 
+TEST_CASE("find") {
+    auto r = rvr::seq(100);
+    CHECK(r.find([](int i){ return i % 7 == 3; }) == Some(3));
+    CHECK(r.find([](int i){ return i % 7 == 3; }) == Some(10));
+    CHECK(r.next() == Some(11));
+    CHECK_FALSE(rvr::find(r, [](int i){ return i > 100; }));
+    CHECK_FALSE(r.next());
+}
+
 TEST_CASE("chain") {
     std::vector<int> a = {1, 2, 3};
     std::list<int> b = {4, 5};
@@ -168,7 +220,7 @@ TEST_CASE("take") {
     }
 
     {
-        auto ints = rvr::seq(1, 00);
+        auto ints = rvr::seq(1, 100);
 
         // this one copies ints, doesn't change the original
         CHECK(ints.take(5).sum() == 15);
@@ -206,3 +258,253 @@ TEST_CASE("drop") {
     }
 }
 
+TEST_CASE("advance") {
+    std::vector<int> v(1000);
+    std::iota(v.begin(), v.end(), 0);
+
+    STATIC_REQUIRE(rvr::AdvanceableRiver<decltype(rvr::from(v))>);
+    STATIC_REQUIRE(rvr::AdvanceableRiver<decltype(rvr::seq(10))>);
+    STATIC_REQUIRE_FALSE(rvr::AdvanceableRiver<decltype(rvr::seq(10).filter([](int){ return true; }))>);
+
+    {
+        auto r = rvr::from(v);
+        CHECK(r.advance(10) == 10);
+        CHECK(r.next() == Some(10));
+        CHECK(r.advance(2000) == 989);
+        CHECK_FALSE(r.next());
+    }
+
+    {
+        // chain advances across its bases
+        auto r = rvr::chain(rvr::from(v), rvr::seq(1000, 1010), rvr::seq(1010, 1020));
+        CHECK(r.advance(1005) == 1005);
+        CHECK(r.next() == Some(1005));
+        CHECK(r.advance(100) == 14);
+        CHECK_FALSE(r.next());
+    }
+
+    {
+        // map doesn't call the function on the elements it skips
+        int calls = 0;
+        auto r = rvr::from(v).map([&](int i){ ++calls; return i * 2; });
+        CHECK(r.ref().drop(500).take(3).into_vec() == std::vector{1000, 1002, 1004});
+        CHECK(calls == 3);
+        CHECK(r.count() == 497);
+        CHECK(calls == 3);
+    }
+
+    {
+        auto page = rvr::from(v).drop(990).take(20);
+        CHECK(rvr::size_hint(page).exact() == 10u);
+        CHECK(page.sum() == 9945);
+        page.reset();
+        CHECK(page.count() == 10);
+    }
+
+    {
+        // drop without advance still skips, by element or by block
+        auto odd = [](int i){ return i % 2 == 1; };
+        CHECK(rvr::from(v).filter(odd).drop(3).next() == Some(7));
+        CHECK(rvr::from(v).filter(odd).drop(498).into_vec() == std::vector{997, 999});
+        CHECK(rvr::from(v).filter(odd).drop(600).into_vec().empty());
+        CHECK(rvr::from(v).drop(-5).count() == 1000);
+    }
+}
+TEST_CASE("for_all") {
+    std::vector<int> v = {1, 2, 3, 4, 5, 6};
+    auto is_even = [](int i){ return i % 2 == 0; };
+    auto square = [](int i){ return i * i; };
+
+    auto r = rvr::chain(rvr::from(v), rvr::seq(7, 10))
+        .drop(1)
+        .filter(is_even)
+        .map(square);
+    STATIC_REQUIRE(rvr::ExhaustiveRiver<decltype(r)>);
+    STATIC_REQUIRE_FALSE(rvr::ExhaustiveRiver<decltype(rvr::from(v).take(3).filter(is_even))>);
+
+    std::vector<int> seen;
+    r.for_each([&](int i){ seen.push_back(i); });
+    CHECK(seen == std::vector{4, 16, 36, 64});
+    CHECK_FALSE(r.next());
+
+    CHECK(rvr::seq(10, 0, -3).fold(0, [](int acc, int i){ return acc * 100 + i; }) == 10'070'401);
+    CHECK(rvr::of(42).count() == 1);
+    CHECK(rvr::seq(1, 10).filter(is_even).map(square).sum() == 120);
+
+    auto once = rvr::of(1);
+    once.consume();
+    CHECK_FALSE(once.next());
+}
+
+TEST_CASE("chunks") {
+    std::vector<int> v(3000);
+    std::iota(v.begin(), v.end(), 0);
+
+    auto r = rvr::from(v);
+    STATIC_REQUIRE(rvr::ChunkedRiver<decltype(r)>);
+    STATIC_REQUIRE_FALSE(rvr::ChunkedRiver<decltype(rvr::seq(10))>);
+
+    std::vector<std::size_t> sizes;
+    CHECK(r.while_chunk([&](std::span<int const> chunk){
+        sizes.push_back(chunk.size());
+        return true;
+    }));
+    CHECK(sizes == std::vector<std::size_t>{1024, 1024, 952});
+    r.reset();
+
+    auto triple = [](int i){ return 3 * i; };
+    auto is_even = [](int i){ return i % 2 == 0; };
+    auto pipeline = r.map(triple).filter(is_even);
+    STATIC_REQUIRE(rvr::ChunkedRiver<decltype(pipeline)>);
+    CHECK(pipeline.sum() == 6745500);
+    pipeline.reset();
+    CHECK(pipeline.count() == 1500);
+
+    // non-numeric maps fall back to while_
+    auto strs = r.map([](int i){ return std::to_string(i); });
+    STATIC_REQUIRE_FALSE(rvr::ChunkedRiver<decltype(strs)>);
+
+    // take never consumes more than it needs from its base
+    CHECK(r.ref().take(2000).sum() == 1999000);
+    CHECK(r.next() == Some(2000));
+    CHECK(r.ref().take(5).count() == 5);
+    CHECK(r.next() == Some(2006));
+
+    auto chained = rvr::from(v).chain(rvr::from(v).filter(is_even));
+    STATIC_REQUIRE(rvr::ChunkedRiver<decltype(chained)>);
+    CHECK(chained.sum() == 4498500 + 2248500);
+}
+
+TEST_CASE("size hints") {
+    auto exactly = [](std::size_t n){ return rvr::SizeHint::exactly(n); };
+    auto hint_of = [](auto const& r){
+        auto h = rvr::size_hint(r);
+        return std::pair(h.lower, h.upper);
+    };
+    using P = std::pair<std::size_t, tl::optional<std::size_t>>;
+
+    CHECK(exactly(4).exact() == Some(std::size_t(4)));
+    CHECK_FALSE(rvr::SizeHint{.lower=1}.exact());
+
+    std::vector<int> v = {1, 2, 3, 4, 5};
+    auto r = rvr::from(v);
+    CHECK(hint_of(r) == P(5, 5));
+    r.next();
+    CHECK(hint_of(r) == P(4, 4));
+
+    CHECK(hint_of(rvr::seq(3, 10)) == P(7, 7));
+    CHECK(hint_of(rvr::of(1)) == P(1, 1));
+    CHECK(hint_of(rvr::seq(10).map([](int i){ return i * i; })) == P(10, 10));
+    CHECK(hint_of(rvr::seq(10).filter([](int i){ return i % 2 == 0; })) == P(0, 10));
+    CHECK(hint_of(rvr::seq(10).take(3)) == P(3, 3));
+    CHECK(hint_of(rvr::seq(2).take(3)) == P(2, 2));
+    CHECK(hint_of(rvr::seq(10).drop(3)) == P(7, 7));
+    CHECK(hint_of(rvr::seq(2).drop(3)) == P(0, 0));
+    CHECK(hint_of(rvr::seq(5).chain(rvr::seq(3))) == P(8, 8));
+
+    std::istringstream iss("1 2 3");
+    auto unknown = rvr::from_stream<int>(iss);
+    CHECK(hint_of(unknown) == P(0, tl::nullopt));
+    CHECK(hint_of(unknown.take(2)) == P(0, 2));
+    CHECK(hint_of(rvr::seq(5).chain(rvr::from_stream<int>(iss))) == P(5, tl::nullopt));
+
+    auto squares = rvr::seq(1000).map([](int i){ return i * i; }).into_vec();
+    CHECK(squares.size() == 1000);
+    CHECK(squares.capacity() == 1000);
+}
+
+TEST_CASE("collect contiguous") {
+    std::vector<int> col(5000);
+    std::iota(col.begin(), col.end(), 0);
+
+    auto slice = rvr::from(col).drop(1500).take(2100);
+    STATIC_REQUIRE(rvr::ChunkedRiver<decltype(slice)>);
+    auto v = slice.into_vec();
+    CHECK(v.capacity() == 2100);
+    CHECK(v == std::vector<int>(col.begin() + 1500, col.begin() + 3600));
+
+    // the rest of a contiguous river is inserted at once, and consumed
+    auto rest = rvr::from(col).drop(1500);
+    STATIC_REQUIRE(rvr::ContiguousRiver<decltype(rest)>);
+    auto w = rvr::collect<std::vector<int>>(rest);
+    CHECK(w.capacity() == 3500);
+    CHECK(w == std::vector<int>(col.begin() + 1500, col.end()));
+    CHECK_FALSE(rest.next());
+
+    CHECK(rvr::from(col).drop(4999).into_vec() == std::vector{4999});
+    CHECK(rvr::from(col).drop(6000).into_vec().empty());
+
+    std::string s = "hello world";
+    CHECK(rvr::from(s).drop(6).into_str() == "world");
+}
+
+TEMPLATE_TEST_CASE("vectorized sum and product", "[simd]",
+                   signed char, unsigned short, int, unsigned, long long)
+{
+    // compute the expected values with wrapping arithmetic
+    using U = std::make_unsigned_t<TestType>;
+    auto plus = [](U a, TestType b) -> U { return a + U(b); };
+    auto times = [](U a, TestType b) -> U { return a * U(b); };
+    auto odd = [](TestType t){ return t % 2 == 1; };
+
+    for (int size : {0, 1, 7, 31, 64, 1023, 1024, 1025, 5000}) {
+        std::vector<TestType> v(size);
+        for (int i = 0; i != size; ++i) {
+            v[i] = TestType(i % 7 + 1);
+        }
+
+        CHECK(rvr::from(v).sum(3) == TestType(std::accumulate(v.begin(), v.end(), U(3), plus)));
+        CHECK(rvr::from(v).product() == TestType(std::accumulate(v.begin(), v.end(), U(1), times)));
+
+        std::vector<TestType> odds;
+        std::ranges::copy_if(v, std::back_inserter(odds), odd);
+        CHECK(rvr::from(v).filter(odd).sum() == TestType(std::accumulate(odds.begin(), odds.end(), U(0), plus)));
+    }
+}
+
+TEMPLATE_TEST_CASE("vectorized filter", "[simd]",
+                   unsigned char, short, int, float, long long, double)
+{
+    for (int size : {0, 1, 31, 32, 33, 100, 1024, 3000}) {
+        std::vector<TestType> v(size);
+        for (int i = 0; i != size; ++i) {
+            v[i] = TestType((i * 37) % 100);
+        }
+
+        for (int selectivity : {0, 10, 50, 90, 100}) {
+            auto keep = [=](TestType t){ return t < TestType(selectivity); };
+
+            std::vector<TestType> expected;
+            std::ranges::copy_if(v, std::back_inserter(expected), keep);
+            CHECK(rvr::from(v).filter(keep).into_vec() == expected);
+        }
+    }
+}
+
+TEST_CASE("compress kernels", "[simd]") {
+    namespace simd = rvr::detail::simd;
+
+    std::vector<int> v(1000);
+    std::iota(v.begin(), v.end(), 0);
+    std::unique_ptr<bool[]> keep(new bool[v.size()]);
+    for (std::size_t i = 0; i != v.size(); ++i) {
+        keep[i] = (i * 7) % 3 != 0;
+    }
+
+    for (std::size_t n : {0, 5, 32, 999, 1000}) {
+        std::vector<int> expected(n + simd::compress_slack);
+        expected.resize(simd::compress_scalar(v.data(), keep.get(), n, expected.data()));
+
+        std::vector<int> out(n + simd::compress_slack);
+        out.resize(simd::compress(v.data(), keep.get(), n, out.data()));
+        CHECK(out == expected);
+
+#if RVR_SIMD_X86
+        if (__builtin_cpu_supports("avx2")) {
+            std::vector<int> avx2(n + simd::compress_slack);
+            avx2.resize(simd::compress_avx2(v.data(), keep.get(), n, avx2.data()));
+            CHECK(avx2 == expected);
+        }
+#endif
+    }
+}
@@ -0,0 +1,174 @@
+#include "catch.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <rivers/rivers.hpp>
+#include "test_utils.hpp"
+
+TEST_CASE("channel", "[channel]") {
+    rvr::channel<int> ch(4);
+    STATIC_REQUIRE(std::same_as<rvr::reference_t<decltype(ch)>, int>);
+    {
+        auto p = ch.producer();
+        CHECK(p.try_push(1));
+        CHECK(p.push(2));
+        int const three = 3;
+        CHECK(p.try_push(three));
+        CHECK(p.push(4));
+        // full
+        int five = 5;
+        CHECK_FALSE(p.try_push(std::move(five)));
+        CHECK(five == 5);
+
+        CHECK(ch.next() == Some(1));
+        CHECK(p.try_push(5));
+        CHECK(ch.ref().take(2).into_vec() == std::vector{2, 3});
+    }
+    // the only producer has closed
+    CHECK(ch.into_vec() == std::vector{4, 5});
+    CHECK_FALSE(ch.next());
+
+    // no producers at all
+    rvr::channel<int> none;
+    none.close();
+    CHECK(none.count() == 0);
+}
+
+TEST_CASE("channel waits for its first producer", "[channel]") {
+    rvr::channel<int> ch;
+    std::jthread late([&]{
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        ch.producer().push(7);
+    });
+    CHECK(ch.into_vec() == std::vector{7});
+}
+
+TEST_CASE("channel consumers don't lose elements", "[channel]") {
+    rvr::channel<int> ch(64);
+    auto p = ch.producer();
+    for (int i = 0; i != 20; ++i) {
+        p.push(i);
+    }
+    p.close();
+
+    auto b = ch;
+    {
+        // a claims a batch and stops early, after b has claimed the next
+        // one - so a can't give the rest of its batch back to the queue
+        auto a = ch;
+        a.while_([&](int i){
+            CHECK(i == 0);
+            CHECK(b.next() == Some(8));
+            return false;
+        });
+    }
+    // so they end up with the other consumers
+    auto rest = b.into_vec();
+    std::vector<int> expected = {1, 2, 3, 4, 5, 6, 7};
+    for (int i = 9; i != 20; ++i) {
+        expected.push_back(i);
+    }
+    CHECK(rest == expected);
+    CHECK(ch.count() == 0);
+}
+
+TEST_CASE("channel from many threads", "[channel]") {
+    auto const capacity = GENERATE(2, 64, 1024);
+    int const threads = 4;
+    int const per_thread = 10'000;
+
+    rvr::channel<int> ch(capacity);
+    std::vector<std::jthread> workers;
+    for (int t = 0; t != threads; ++t) {
+        workers.emplace_back([p = ch.producer(), t]() mutable {
+            for (int i = 0; i != per_thread; ++i) {
+                p.push(t * per_thread + i);
+            }
+        });
+    }
+
+    std::vector<int> next(threads, 0);
+    bool in_order = true;
+    long long total = 0;
+    ch.for_each([&](int i){
+        // each producer's elements arrive in the order it pushed them
+        int const t = i / per_thread;
+        in_order = in_order and i % per_thread == next[t]++;
+        total += i;
+    });
+    CHECK(in_order);
+    long long const n = threads * per_thread;
+    CHECK(total == n * (n - 1) / 2);
+}
+
+TEST_CASE("channel with many consumers", "[channel]") {
+    long long const n = 100'000;
+    std::atomic<long long> total = 0;
+    {
+        rvr::channel<int> ch(16);
+        std::jthread producer([p = ch.producer()]() mutable {
+            for (int i = 0; i != n; ++i) {
+                p.push(i);
+            }
+        });
+
+        // copies of the channel share out its elements
+        std::vector<std::jthread> consumers;
+        for (int t = 0; t != 3; ++t) {
+            consumers.emplace_back([ch, &total]() mutable {
+                total += ch.map([](int i){ return (long long)i; }).sum();
+            });
+        }
+    }
+    CHECK(total.load() == n * (n - 1) / 2);
+}
+
+TEST_CASE("channel composes", "[channel]") {
+    rvr::channel<char> ch;
+    {
+        auto p = ch.producer();
+        for (char c : std::string("one two  three")) {
+            p.push(c);
+        }
+    }
+    auto words = ch.ref()
+        .split(' ')
+        .map(rvr::collect<std::string>)
+        .filter([](std::string const& w){ return not w.empty(); })
+        .take(2)
+        .into_vec();
+    CHECK(words == std::vector<std::string>{"one", "two"});
+    // what take left behind is still there
+    CHECK(ch.into_vec() == std::vector{' ', 't', 'h', 'r', 'e', 'e'});
+
+    // move-only elements
+    rvr::channel<std::unique_ptr<int>> owned;
+    {
+        auto p = owned.producer();
+        for (int i = 0; i != 10; ++i) {
+            p.push(std::make_unique<int>(i));
+        }
+    }
+    CHECK(owned.map([](std::unique_ptr<int> p){ return *p; }).sum() == 45);
+}
+
+TEST_CASE("channel producers stop once nobody consumes", "[channel]") {
+    std::atomic<int> pushed = 0;
+    std::jthread worker;
+    {
+        rvr::channel<int> ch(8);
+        worker = std::jthread([p = ch.producer(), &pushed]() mutable {
+            while (p.push(pushed)) {
+                ++pushed;
+            }
+        });
+        CHECK(ch.any([](int i){ return i == 100; }));
+    }
+    // without any consumers left, push fails rather than waiting forever
+    worker.join();
+    CHECK(pushed.load() >= 101);
+}
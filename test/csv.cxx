@@ -0,0 +1,100 @@
+#include "catch.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <rivers/rivers.hpp>
+#include "test_utils.hpp"
+
+namespace {
+    // the values of every field of every record
+    auto values(auto&& records) -> std::vector<std::vector<std::string>> {
+        return RVR_FWD(records)
+            .map([](rvr::CsvRow row){
+                std::vector<std::string> fields;
+                for (rvr::CsvField const& f : row) {
+                    fields.push_back(f.str());
+                }
+                return fields;
+            })
+            .into_vec();
+    }
+
+    using Records = std::vector<std::vector<std::string>>;
+}
+
+TEST_CASE("csv", "[csv]") {
+    using namespace std::literals;
+
+    std::string s = "name,qty,note\r\n"
+                    "apple,3,\"red, round\"\r\n"
+                    "pear,,\"says \"\"hi\"\"\"\n"
+                    "\"multi\nline\",1,\n";
+    auto records = rvr::csv(s);
+    STATIC_REQUIRE(std::same_as<rvr::reference_t<decltype(records)>, rvr::CsvRow>);
+    STATIC_REQUIRE(rvr::ResettableRiver<decltype(records)>);
+
+    CHECK(values(records) == Records{
+        {"name", "qty", "note"},
+        {"apple", "3", "red, round"},
+        {"pear", "", "says \"hi\""},
+        {"multi\nline", "1", ""},
+    });
+
+    // fields point into the source, and are only unescaped when asked
+    records.reset();
+    auto third = records.ref().drop(2).next();
+    REQUIRE(third);
+    REQUIRE(third->size() == 3);
+    CHECK((*third)[0].raw() == "pear"sv);
+    CHECK((*third)[0].raw().data() == s.data() + s.find("pear"));
+    CHECK((*third)[2].escaped());
+    CHECK((*third)[2].raw() == "says \"\"hi\"\""sv);
+    CHECK_FALSE((*third)[0].escaped());
+
+    // composes like any other river
+    records.reset();
+    auto const qty = records
+        .drop(1)
+        .filter([](rvr::CsvRow row){ return not row[1].raw().empty(); })
+        .map([](rvr::CsvRow row){ return std::stoi(row[1].str()); })
+        .sum();
+    CHECK(qty == 4);
+}
+
+TEST_CASE("csv edge cases", "[csv]") {
+    // no trailing newline, empty records, and a lone quote
+    std::string_view const s1 = "a\n\nb,\"\"\n\"";
+    CHECK(values(rvr::csv(s1)) == Records{{"a"}, {""}, {"b", ""}, {"\""}});
+    std::string_view const s2 = "";
+    CHECK(values(rvr::csv(s2)).empty());
+    std::string_view const s3 = "\r\n";
+    CHECK(values(rvr::csv(s3)) == Records{{""}});
+
+    // TSV, with another quote character
+    std::string tsv = "a\t'b\tc'\t'it''s'\n";
+    CHECK(values(rvr::csv(tsv, {.separator='\t', .quote='\''})) == Records{{"a", "b\tc", "it's"}});
+}
+
+TEST_CASE("csv across blocks", "[csv]") {
+    // fields and quotes straddling the 64 byte blocks the scan works on
+    Records expected;
+    std::string s;
+    for (int i = 0; i != 200; ++i) {
+        std::string const plain(i % 70, 'x');
+        std::string const quoted = std::string(i % 13, 'q') + ",\n\"" + std::string(i % 50, 'y');
+        expected.push_back({plain, quoted, std::to_string(i)});
+
+        s += plain + ",\"";
+        for (char c : quoted) {
+            s += c;
+            if (c == '"') {
+                s += c;
+            }
+        }
+        s += "\"," + std::to_string(i) + (i % 2 ? "\r\n" : "\n");
+    }
+
+    CHECK(values(rvr::csv(s)) == expected);
+    CHECK(rvr::csv(s).count() == 200);
+}
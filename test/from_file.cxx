@@ -0,0 +1,117 @@
+#include "catch.hpp"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <rivers/rivers.hpp>
+#include "test_utils.hpp"
+
+TEST_CASE("from_file", "[file]") {
+    TempFile file("hello\nworld\n");
+
+    auto chars = rvr::from_file<char>(file.path);
+    STATIC_REQUIRE(rvr::ChunkedRiver<decltype(chars)>);
+    STATIC_REQUIRE(rvr::ResettableRiver<decltype(chars)>);
+    CHECK(rvr::size_hint(chars).exact() == 12u);
+    CHECK(chars.filter([](char c){ return c == 'o'; }).count() == 2);
+    chars.reset();
+    CHECK(chars.into_vec() == std::vector<char>{'h', 'e', 'l', 'l', 'o', '\n', 'w', 'o', 'r', 'l', 'd', '\n'});
+
+    auto bytes = rvr::from_file_bytes(file.path, {.populate=true});
+    STATIC_REQUIRE(std::same_as<rvr::value_t<decltype(bytes)>, std::byte>);
+    CHECK(bytes.drop(6).next() == Some(std::byte('w')));
+
+    TempFile empty;
+    CHECK(rvr::from_file_bytes(empty.path).count() == 0);
+    CHECK(rvr::from_file_lines(empty.path).count() == 0);
+
+    CHECK_THROWS_AS(rvr::from_file_bytes("/nonexistent/rivers/file"), std::system_error);
+}
+
+TEST_CASE("from_file_lines", "[file]") {
+    TempFile file("one\n\nthree\nfour");
+
+    auto lines = rvr::from_file_lines(file.path);
+    STATIC_REQUIRE(std::same_as<rvr::reference_t<decltype(lines)>, std::string_view>);
+    CHECK(lines.into_vec() == std::vector<std::string_view>{"one", "", "three", "four"});
+    CHECK_FALSE(lines.next());
+
+    lines.reset();
+    CHECK(lines.next() == Some(std::string_view("one")));
+    CHECK(lines.map(&std::string_view::size).sum() == 9u);
+
+    TempFile trailing("a\nb\n");
+    CHECK(rvr::from_file_lines(trailing.path).count() == 2);
+}
+
+TEST_CASE("from_file_lines split", "[file]") {
+    std::string contents;
+    for (int i = 0; i != 1000; ++i) {
+        contents += std::to_string(i) + '\n';
+    }
+    TempFile file(contents);
+
+    auto lines = rvr::from_file_lines(file.path);
+    auto prefix = lines.try_split();
+    REQUIRE(prefix);
+
+    // the pieces split between lines
+    auto to_int = [](std::string_view s){ return std::stoi(std::string(s)); };
+    auto first = prefix->map(to_int).into_vec();
+    auto second = lines.map(to_int).into_vec();
+    REQUIRE_FALSE(first.empty());
+    REQUIRE_FALSE(second.empty());
+    CHECK(first.front() == 0);
+    CHECK(first.back() + 1 == second.front());
+    CHECK(second.back() == 999);
+
+    rvr::thread_pool pool(3);
+    CHECK(rvr::from_file_lines(file.path).par(pool).map(to_int).sum() == 499'500);
+    CHECK(rvr::from_file<char>(file.path).par(pool).count() == int(contents.size()));
+}
+
+namespace {
+    struct Point {
+        int x;
+        double y;
+        friend auto operator==(Point const&, Point const&) -> bool = default;
+    };
+}
+
+TEST_CASE("from_records", "[file]") {
+    TempFile file;
+    auto const& path = file.path;
+    std::vector<Point> points;
+    for (int i = 0; i != 5000; ++i) {
+        points.push_back({i, i * 0.5});
+    }
+
+    // chunked, and not
+    CHECK(rvr::write_records(rvr::from(points), path) == 5000u);
+    CHECK(std::filesystem::file_size(path) == 5000 * sizeof(Point));
+    CHECK(rvr::write_records(rvr::seq(5000).map([](int i){ return Point{i, i * 0.5}; }), path) == 5000u);
+    CHECK(std::filesystem::file_size(path) == 5000 * sizeof(Point));
+
+    auto records = rvr::from_records<Point>(path);
+    STATIC_REQUIRE(std::same_as<rvr::reference_t<decltype(records)>, Point const&>);
+    STATIC_REQUIRE(rvr::ResettableRiver<decltype(records)>);
+    STATIC_REQUIRE(rvr::ContiguousRiver<decltype(records)>);
+    CHECK(records.into_vec() == points);
+
+    // drop and take stay contiguous, and skip without reading anything
+    records.reset();
+    auto middle = records.ref().drop(1000).take(10);
+    STATIC_REQUIRE(rvr::ContiguousRiver<decltype(middle)>);
+    CHECK(middle.remaining().size() == 10u);
+    CHECK(&middle.remaining()[0] == &records.remaining()[1000]);
+    CHECK(middle.next() == Some(Point{1000, 500.0}));
+    CHECK(middle.count() == 9);
+    CHECK(records.next() == Some(Point{1010, 505.0}));
+
+    CHECK(rvr::write_records(rvr::from(std::vector<Point>{}), path) == 0u);
+    CHECK(rvr::from_records<Point>(path).count() == 0);
+
+    TempFile odd(std::string(sizeof(Point) + 1, 'x'));
+    CHECK_THROWS_AS(rvr::from_records<Point>(odd.path), std::runtime_error);
+    CHECK_THROWS_AS(rvr::write_records(rvr::from(points), "/nonexistent/rivers/file"), std::system_error);
+}
@@ -0,0 +1,183 @@
+#include "catch.hpp"
+
+#include <memory>
+#include <numeric>
+#include <span>
+#include <vector>
+#include <rivers/rivers.hpp>
+#include "test_utils.hpp"
+
+TEST_CASE("split pieces", "[par]") {
+    std::vector<int> v(10);
+    std::iota(v.begin(), v.end(), 0);
+
+    auto r = rvr::from(v);
+    STATIC_REQUIRE(rvr::SplittableRiver<decltype(r)>);
+    STATIC_REQUIRE(rvr::SplittableRiver<rvr::split_t<decltype(r)>>);
+
+    auto prefix = r.try_split();
+    REQUIRE(prefix);
+    CHECK(prefix->into_vec() == std::vector{0, 1, 2, 3, 4});
+    CHECK(r.into_vec() == std::vector{5, 6, 7, 8, 9});
+
+    auto ints = rvr::seq(3, 6).map([](int i){ return i * 10; });
+    auto first = ints.try_split();
+    REQUIRE(first);
+    CHECK(first->into_vec() == std::vector{30});
+    CHECK(ints.try_split()->into_vec() == std::vector{40});
+    CHECK_FALSE(ints.try_split());
+    CHECK(ints.into_vec() == std::vector{50});
+}
+
+TEST_CASE("split chain and take", "[par]") {
+    auto c = rvr::chain(rvr::seq(0, 4), rvr::seq(4, 6), rvr::seq(6, 10));
+    using prefix_t = rvr::split_t<decltype(c)>;
+    STATIC_REQUIRE(std::same_as<rvr::split_t<prefix_t>, prefix_t>);
+    CHECK(rvr::size_hint(c).exact() == 10u);
+
+    // first between the bases...
+    auto first = c.try_split();
+    REQUIRE(first);
+    CHECK(rvr::size_hint(*first).exact() == 4u);
+    CHECK(rvr::size_hint(c).exact() == 6u);
+
+    // ... then within the only one left
+    auto second = first->try_split();
+    REQUIRE(second);
+    CHECK(second->into_vec() == std::vector{0, 1});
+    CHECK(first->into_vec() == std::vector{2, 3});
+    CHECK(c.into_vec() == std::vector{4, 5, 6, 7, 8, 9});
+
+    std::vector<int> v(100);
+    std::iota(v.begin(), v.end(), 0);
+
+    // from splits into a subrange, which a chain keeps splitting within
+    auto fc = rvr::chain(rvr::from(std::span(v).first(50)), rvr::from(std::span(v).subspan(50)));
+    auto fc_first = fc.try_split();
+    REQUIRE(fc_first);
+    auto fc_second = fc_first->try_split();
+    REQUIRE(fc_second);
+    auto fc_third = fc_second->try_split();
+    REQUIRE(fc_third);
+    CHECK(fc_third->into_vec() == std::vector<int>(v.begin(), v.begin() + 12));
+    CHECK(fc_second->into_vec() == std::vector<int>(v.begin() + 12, v.begin() + 25));
+    CHECK(fc_first->into_vec() == std::vector<int>(v.begin() + 25, v.begin() + 50));
+    CHECK(fc.into_vec() == std::vector<int>(v.begin() + 50, v.end()));
+
+    // bases are moved into the prefix rather than copied, so they can own
+    // things that can't be copied
+    std::vector<std::unique_ptr<int>> owned;
+    owned.push_back(std::make_unique<int>(1));
+    owned.push_back(std::make_unique<int>(2));
+    auto deref = [](std::unique_ptr<int>& p){ return *p; };
+    auto oc = rvr::chain(rvr::from(std::move(owned)).map(deref), rvr::seq(3, 5));
+    auto oc_first = oc.try_split();
+    REQUIRE(oc_first);
+    CHECK(oc_first->into_vec() == std::vector{1, 2});
+    CHECK(oc.into_vec() == std::vector{3, 4});
+
+    auto t = rvr::from(v).take(6);
+    auto head = t.try_split();
+    REQUIRE(head);
+    CHECK(head->into_vec() == std::vector{0, 1, 2, 3, 4, 5});
+    CHECK(t.into_vec().empty());
+
+    auto t2 = rvr::from(std::span(v).first(10)).take(8);
+    auto head2 = t2.try_split();
+    REQUIRE(head2);
+    CHECK(head2->into_vec() == std::vector{0, 1, 2, 3, 4});
+    CHECK(t2.into_vec() == std::vector{5, 6, 7});
+
+    // a filter's size isn't known, so neither is how much of it to take
+    auto t3 = rvr::seq(10).filter([](int i){ return i % 2 == 0; }).take(3);
+    STATIC_REQUIRE(rvr::SplittableRiver<decltype(t3)>);
+    CHECK_FALSE(t3.try_split());
+    CHECK(t3.into_vec() == std::vector{0, 2, 4});
+
+    rvr::thread_pool pool(3);
+    std::vector<int> w = {1, 2, 3};
+    CHECK(rvr::chain(rvr::from(w), rvr::seq(4, 1001)).take(500).par(pool).sum() == 125'250);
+    CHECK(rvr::chain(rvr::from(v), rvr::from(w)).par(pool).into_vec() == rvr::chain(rvr::from(v), rvr::from(w)).into_vec());
+}
+
+TEST_CASE("parallel terminals", "[par]") {
+    std::vector<long long> v(100'000);
+    std::iota(v.begin(), v.end(), 1);
+
+    auto triple = [](long long i){ return 3 * i; };
+    auto is_even = [](long long i){ return i % 2 == 0; };
+
+    for (std::size_t threads : {1, 2, 3, 8}) {
+        rvr::thread_pool pool(threads);
+        CHECK(rvr::from(v).par(pool).sum() == 5'000'050'000);
+        CHECK(rvr::from(v).par(pool).map(triple).filter(is_even).sum() == 7'500'150'000);
+        CHECK(rvr::par(rvr::seq(1000), pool).filter(is_even).count() == 500);
+        CHECK(rvr::seq(1LL, 21LL).par(pool).product() == 2'432'902'008'176'640'000);
+
+        CHECK(rvr::from(v).par(pool).all([](long long i){ return i > 0; }));
+        CHECK_FALSE(rvr::from(v).par(pool).all([](long long i){ return i < 99'999; }));
+        CHECK(rvr::from(v).par(pool).any([](long long i){ return i == 77'777; }));
+        CHECK(rvr::from(v).par(pool).none([](long long i){ return i == 0; }));
+
+        auto digits = rvr::seq(10).par(pool).fold(std::string(),
+            [](std::string s, int i){ return s + char('0' + i); },
+            std::plus());
+        CHECK(digits == "0123456789");
+
+        auto evens = rvr::seq(10'000).par(pool).filter(is_even).into_vec();
+        REQUIRE(evens.size() == 5'000);
+        CHECK(std::ranges::is_sorted(evens));
+        CHECK(evens.back() == 9'998);
+    }
+
+    // by default, on the global pool
+    CHECK(rvr::from(v).par().sum() == 5'000'050'000);
+    CHECK(rvr::par(rvr::seq(1000)).filter(is_even).count() == 500);
+}
+
+TEST_CASE("parallel collect", "[par]") {
+    std::vector<int> v(100'000);
+    std::iota(v.begin(), v.end(), 0);
+    auto every_tenth = [](int i){ return i % 10 == 0; };
+
+    for (std::size_t threads : {1, 2, 3, 8}) {
+        rvr::thread_pool pool(threads);
+        auto const expected = rvr::from(v).filter(every_tenth).into_vec();
+
+        CHECK(rvr::from(v).par(pool).filter(every_tenth).into_vec() == expected);
+        CHECK(rvr::seq(100'000).par(pool).filter(every_tenth).collect<std::vector>() == expected);
+
+        // converting, and non-trivial elements
+        auto longs = rvr::from(v).par(pool).filter(every_tenth).collect<std::vector<long>>();
+        CHECK(longs == std::vector<long>(expected.begin(), expected.end()));
+        auto strings = rvr::seq(1000).par(pool).map([](int i){ return std::to_string(i); }).into_vec();
+        CHECK(strings == rvr::seq(1000).map([](int i){ return std::to_string(i); }).into_vec());
+
+        // packed bits, which are appended one piece at a time
+        auto is_even = [](int i){ return i % 2 == 0; };
+        auto bits = rvr::seq(100'000).par(pool).map(is_even).into_vec();
+        CHECK(bits == rvr::seq(100'000).map(is_even).into_vec());
+
+        // which can't be default constructed, so go in one at a time
+        struct boxed {
+            int i;
+            explicit boxed(int i) : i(i) { }
+            auto operator==(boxed const&) const -> bool = default;
+        };
+        auto boxes = rvr::seq(1000).par(pool).map([](int i){ return boxed(i); }).into_vec();
+        CHECK(boxes == rvr::seq(1000).map([](int i){ return boxed(i); }).into_vec());
+
+        CHECK(rvr::seq(0).par(pool).into_vec().empty());
+    }
+}
+
+TEST_CASE("parallel exceptions", "[par]") {
+    rvr::thread_pool pool(4);
+    auto r = rvr::seq(100).par(pool).map([](int i){
+        if (i == 10) {
+            throw std::runtime_error("ten");
+        }
+        return i;
+    });
+    CHECK_THROWS_AS(r.sum(), std::runtime_error);
+}
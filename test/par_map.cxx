@@ -0,0 +1,77 @@
+#include "catch.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <rivers/rivers.hpp>
+#include "test_utils.hpp"
+
+TEST_CASE("par_map keeps the order", "[par_map]") {
+    auto const workers = GENERATE(1, 2, 4);
+    auto const window = GENERATE(1, 3, 64);
+
+    std::istringstream iss("1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20");
+    auto r = rvr::from_stream<int>(iss)
+        .par_map([](int i){ return std::to_string(i * i); }, workers, window);
+    STATIC_REQUIRE(std::same_as<rvr::reference_t<decltype(r)>, std::string>);
+    CHECK(r.next() == Some(std::string("1")));
+    CHECK(r.ref().take(2).into_vec() == std::vector<std::string>{"4", "9"});
+    CHECK(std::move(r).map([](std::string const& s){ return std::stoi(s); }).sum() == 2870 - 14);
+
+    auto const expected = rvr::seq(10'000).map([](int i){ return i * 3; }).into_vec();
+    CHECK(rvr::seq(10'000).par_map([](int i){ return i * 3; }, workers, window).into_vec() == expected);
+}
+
+TEST_CASE("par_map_unordered", "[par_map]") {
+    auto const window = GENERATE(1, 16, 256);
+
+    auto r = rvr::seq(10'000).par_map_unordered([](int i){ return i * 3; }, 4, window);
+    auto v = r.into_vec();
+    std::sort(v.begin(), v.end());
+    CHECK(v == rvr::seq(10'000).map([](int i){ return i * 3; }).into_vec());
+    CHECK(rvr::seq(0).par_map_unordered([](int i){ return i; }).count() == 0);
+}
+
+TEST_CASE("par_map runs f in parallel", "[par_map]") {
+    // f only returns once two calls to it have overlapped, which would
+    // never happen if it ran on one thread at a time
+    std::atomic<int> running = 0;
+    std::atomic<bool> overlapped = false;
+    auto f = [&](int i){
+        ++running;
+        while (not overlapped) {
+            if (running.load() > 1) {
+                overlapped = true;
+            }
+            std::this_thread::yield();
+        }
+        --running;
+        return i;
+    };
+    CHECK(rvr::seq(100).par_map(f, 2, 8).sum() == 4950);
+}
+
+TEST_CASE("par_map rethrows", "[par_map]") {
+    auto r = rvr::seq(100).par_map([](int i){
+        if (i == 40) {
+            throw std::runtime_error("f");
+        }
+        return i;
+    }, 4, 8);
+
+    std::vector<int> seen;
+    CHECK_THROWS_AS(r.for_each([&](int i){ seen.push_back(i); }), std::runtime_error);
+    CHECK(seen == rvr::seq(40).into_vec());
+    // and carries on after it
+    CHECK(r.next() == Some(41));
+
+    // stopping early
+    std::atomic<int> calls = 0;
+    CHECK(rvr::seq(1'000'000).par_map([&](int i){ ++calls; return i; }, 2, 16)
+        .any([](int i){ return i == 10; }));
+    CHECK(calls.load() <= 11 + 16);
+}
@@ -0,0 +1,105 @@
+#include "catch.hpp"
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <rivers/rivers.hpp>
+#include "test_utils.hpp"
+
+#include <unistd.h>
+
+TEST_CASE("parse_stream", "[parse]") {
+    {
+        std::istringstream iss("1 2 3\n\t-4  +5\r\n");
+        CHECK(rvr::parse_stream<int>(iss).into_vec() == std::vector{1, 2, 3, -4, 5});
+    }
+
+    {
+        std::istringstream iss("1.5 -2.25e1 3");
+        CHECK(rvr::parse_stream<double>(iss).into_vec() == std::vector{1.5, -22.5, 3.0});
+    }
+
+    // stops at the first token that doesn't parse, or only partially parses
+    {
+        std::istringstream iss("1 2 x 3");
+        CHECK(rvr::parse_stream<int>(iss).into_vec() == std::vector{1, 2});
+    }
+    {
+        std::istringstream iss("1 2.5 3");
+        CHECK(rvr::parse_stream<int>(iss).into_vec() == std::vector{1});
+    }
+    {
+        std::istringstream iss("1 2 300 4");
+        CHECK(rvr::parse_stream<unsigned char>(iss).count() == 2);
+    }
+
+    // empty, or only whitespace
+    {
+        std::istringstream iss("");
+        CHECK(rvr::parse_stream<int>(iss).count() == 0);
+        std::istringstream iss2(" \n\n ");
+        CHECK(rvr::parse_stream<int>(iss2).count() == 0);
+    }
+
+    // resuming
+    {
+        std::istringstream iss("1 2 3 4 5");
+        auto r = rvr::parse_stream<int>(iss);
+        CHECK(r.next() == Some(1));
+        CHECK(r.ref().take(2).sum() == 5);
+        CHECK(r.sum() == 9);
+        CHECK_FALSE(r.next());
+    }
+}
+
+TEST_CASE("parse_stream buffer boundaries", "[parse]") {
+    std::string text;
+    std::vector<long> expected;
+    for (long i = 0; i < 1000; ++i) {
+        long const v = (i * 7919) % 100003 - 50000;
+        text += std::to_string(v);
+        text += (i % 5 == 0) ? "\n  " : " ";
+        expected.push_back(v);
+    }
+
+    // tiny buffers make most tokens straddle a refill, and the smallest ones
+    // have to grow to fit a whole token
+    for (std::size_t capacity : {1, 2, 3, 7, 64, 1 << 16}) {
+        std::istringstream iss(text);
+        auto r = rvr::ParseStream<long, rvr::detail::istream_source>({&iss}, capacity);
+        CHECK(r.into_vec() == expected);
+    }
+
+    // the last token runs right up to the end of the input
+    std::istringstream iss("12 345");
+    auto r = rvr::ParseStream<int, rvr::detail::istream_source>({&iss}, 2);
+    CHECK(r.into_vec() == std::vector{12, 345});
+
+    // prefixes of a token can be valid on their own
+    std::istringstream iss2("1.5e5 +2 -0.25 x");
+    auto d = rvr::ParseStream<double, rvr::detail::istream_source>({&iss2}, 3);
+    CHECK(d.into_vec() == std::vector{1.5e5, 2.0, -0.25});
+}
+
+TEST_CASE("parse_stream FILE* and fd", "[parse]") {
+    std::string const text = "10 20 30\n40\n";
+
+    {
+        std::FILE* file = std::tmpfile();
+        REQUIRE(file);
+        std::fputs(text.c_str(), file);
+        std::rewind(file);
+        CHECK(rvr::parse_stream<int>(file).sum() == 100);
+        std::fclose(file);
+    }
+
+    {
+        int fds[2];
+        REQUIRE(::pipe(fds) == 0);
+        REQUIRE(::write(fds[1], text.data(), text.size()) == ssize_t(text.size()));
+        ::close(fds[1]);
+        CHECK(rvr::parse_fd<short>(fds[0]).into_vec() == std::vector<short>{10, 20, 30, 40});
+        ::close(fds[0]);
+    }
+}
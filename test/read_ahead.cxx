@@ -0,0 +1,71 @@
+#include "catch.hpp"
+
+#include <string>
+#include <vector>
+#include <rivers/rivers.hpp>
+#include "test_utils.hpp"
+
+namespace {
+    // n bytes of text that doesn't repeat every block
+    auto pattern(std::size_t n) -> std::string {
+        std::string contents;
+        for (std::size_t i = 0; i != n; ++i) {
+            contents.push_back(char('a' + (i * 7 + i / 251) % 26));
+        }
+        return contents;
+    }
+
+    auto concat(auto&& blocks) -> std::string {
+        std::string out;
+        RVR_FWD(blocks).for_each([&](std::span<std::byte const> block){
+            out.append(reinterpret_cast<char const*>(block.data()), block.size());
+        });
+        return out;
+    }
+}
+
+TEST_CASE("read_ahead", "[file]") {
+    TempFile file(pattern(100'003));
+    bool const io_uring = GENERATE(true, false);
+    bool const direct = GENERATE(false, true);
+    rvr::ReadAheadOptions const options{.block_size=8192, .depth=3, .direct=direct, .io_uring=io_uring};
+
+    auto blocks = rvr::read_ahead(file.path, options);
+    STATIC_REQUIRE(std::same_as<rvr::reference_t<decltype(blocks)>, std::span<std::byte const>>);
+    CHECK(rvr::size_hint(blocks).upper == 13u);
+    CHECK(concat(blocks) == file.contents);
+    CHECK_FALSE(blocks.next());
+
+    // every block is whole but the last, and they're read further ahead
+    // while each one is in use
+    std::vector<std::size_t> sizes;
+    rvr::read_ahead(file.path, options).for_each([&](std::span<std::byte const> block){
+        sizes.push_back(block.size());
+    });
+    REQUIRE(sizes.size() == 13);
+    CHECK(sizes.front() == 8192u);
+    CHECK(sizes.back() == 100'003u % 8192);
+
+    // stopping early, with reads still in flight
+    auto first = rvr::read_ahead(file.path, options);
+    CHECK(concat(first.ref().take(2)) == file.contents.substr(0, 2 * 8192));
+    CHECK(concat(first.ref().take(1)) == file.contents.substr(2 * 8192, 8192));
+    auto moved = std::move(first);
+    CHECK(concat(moved) == file.contents.substr(3 * 8192));
+
+    // block sizes are rounded up to a page
+    CHECK(concat(rvr::read_ahead(file.path, {.block_size=100, .io_uring=io_uring})) == file.contents);
+    CHECK(rvr::read_ahead(file.path, {.block_size=1 << 20, .depth=64, .io_uring=io_uring}).count() == 1);
+}
+
+TEST_CASE("read_ahead edge cases", "[file]") {
+    TempFile empty;
+    CHECK(rvr::read_ahead(empty.path).count() == 0);
+    CHECK(rvr::read_ahead(empty.path, {.io_uring=false}).count() == 0);
+
+    TempFile exact(pattern(3 * 4096));
+    CHECK(rvr::read_ahead(exact.path, {.block_size=4096, .depth=1}).count() == 3);
+    CHECK(concat(rvr::read_ahead(exact.path, {.block_size=4096, .depth=1, .io_uring=false})) == exact.contents);
+
+    CHECK_THROWS_AS(rvr::read_ahead("/nonexistent/rivers/file"), std::system_error);
+}
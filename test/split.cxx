@@ -1,6 +1,9 @@
 #include "catch.hpp"
 
+#include <bitset>
+#include <cctype>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <rivers/rivers.hpp>
 #include "test_utils.hpp"
@@ -95,3 +98,199 @@ TEST_CASE("count after next", "[split]") {
     CHECK(r.next().map(rvr::count) == Some(1));
     CHECK(r.next().map(rvr::count) == Some(5));
 }
+
+TEST_CASE("split words with all", "[split]") {
+    std::string s = "abc de f";
+    auto all_lower = rvr::from(s)
+        .split(' ')
+        .map([](auto&& word){ return word.all([](char c){ return 'a' <= c and c <= 'z'; }); });
+    CHECK(all_lower.all());
+
+    // same thing, but over a river that isn't contiguous
+    auto letters = rvr::seq('a', 'g').map([](char c){ return c == 'd' ? ' ' : c; });
+    STATIC_REQUIRE_FALSE(rvr::ContiguousRiver<decltype(letters)>);
+    CHECK(letters.split(' ').map([](auto&& word){ return word.all(); }).all());
+}
+
+TEST_CASE("split on a sequence", "[split]") {
+    using namespace std::literals;
+
+    std::string s = "GET / HTTP/1.1\r\nHost: x\r\n\r\nbody";
+    auto lines = rvr::from(s).split("\r\n").map(rvr::collect<std::string>);
+    CHECK(lines.into_vec() == std::vector{"GET / HTTP/1.1"s, "Host: x"s, ""s, "body"s});
+
+    // overlapping and partial matches
+    std::string t = "a|||b||c|";
+    CHECK(rvr::from(t).split("||"sv).map(rvr::collect<std::string>).into_vec()
+          == std::vector{"a"s, "|b"s, "c|"s});
+
+    // a single element pattern is just a delimiter, and an empty one never matches
+    CHECK(rvr::from(t).split(std::string("|")).count() == 7);
+    CHECK(rvr::from(t).split(""sv).count() == 1);
+
+    // not just bytes
+    std::vector<int> v = {1, 0, 0, 2, 3, 0, 4, 0, 0};
+    auto pieces = rvr::from(v).split(std::vector{0, 0}).map(rvr::into_vec);
+    CHECK(pieces.into_vec() == std::vector<std::vector<int>>{{1}, {2, 3, 0, 4}, {}});
+}
+
+TEST_CASE("split a large buffer", "[split]") {
+    // long enough to go through whole vectors, with delimiters right at the
+    // start and end of them
+    std::string s;
+    std::vector<std::string> expected;
+    for (int i = 0; i != 300; ++i) {
+        expected.emplace_back(i % 37, char('a' + i % 26));
+        s += expected.back();
+        s += "\r\n";
+    }
+    s.resize(s.size() - 2);
+
+    auto by_pattern = rvr::from(s).split("\r\n").map(rvr::collect<std::string>);
+    CHECK(by_pattern.into_vec() == expected);
+
+    auto by_char = rvr::from(s).split('\n').map(rvr::collect<std::string>);
+    auto with_cr = by_char.into_vec();
+    REQUIRE(with_cr.size() == expected.size());
+    CHECK(with_cr[0] == expected[0] + "\r");
+    CHECK(with_cr.back() == expected.back());
+
+    // stopping partway through a piece
+    auto r = rvr::from(s).split("\r\n").map([](auto&& line){ return line.next(); });
+    CHECK(r.drop(2).next() == Some(Some('c')));
+}
+
+TEST_CASE("find kernels", "[split]") {
+    std::string s;
+    for (int i = 0; i != 1000; ++i) {
+        s += char('a' + (i * 7) % 5);
+    }
+    auto const p = reinterpret_cast<unsigned char const*>(s.data());
+
+    for (std::string pattern : {"x", "e", "ab", "cea", "bdacebd", "abcdex"}) {
+        auto const q = reinterpret_cast<unsigned char const*>(pattern.data());
+        for (std::size_t n : {0, 1, 5, 31, 32, 33, 64, 100, 1000}) {
+            std::size_t const expected = std::min(std::string_view(s.data(), n).find(pattern), n);
+            CHECK(rvr::detail::simd::find_bytes(p, n, q, pattern.size()) == expected);
+            CHECK(rvr::detail::simd::find_bytes_scalar(p, n, q, pattern.size()) == expected);
+#if RVR_SIMD_X86
+            if (pattern.size() > 1 and rvr::detail::simd::has_avx2()) {
+                CHECK(rvr::detail::simd::find_bytes_avx2(p, n, q, pattern.size()) == expected);
+            }
+#endif
+        }
+    }
+}
+
+TEST_CASE("split_views", "[split]") {
+    using namespace std::literals;
+
+    std::string s = "GET /a 200,GET /b 404,,POST /c 200";
+    auto r = rvr::from(s).split_views(',');
+    STATIC_REQUIRE(std::same_as<rvr::reference_t<decltype(r)>, std::string_view>);
+    STATIC_REQUIRE(rvr::ResettableRiver<decltype(r)>);
+    CHECK(rvr::size_hint(r).lower == 1u);
+
+    auto const pieces = r.into_vec();
+    CHECK(pieces == std::vector{"GET /a 200"sv, "GET /b 404"sv, ""sv, "POST /c 200"sv});
+    // the pieces point into s
+    CHECK(pieces[1].data() == s.data() + 11);
+    CHECK(rvr::size_hint(r).exact() == 0u);
+
+    r.reset();
+    CHECK(r.next() == Some("GET /a 200"sv));
+    CHECK(r.count() == 3);
+
+    // like split, an empty river has one empty piece, and a trailing
+    // delimiter is followed by an empty piece
+    std::string empty;
+    CHECK(rvr::from(empty).split_views(',').into_vec() == std::vector{""sv});
+    std::string trailing = "a\r\nb\r\n";
+    CHECK(rvr::from(trailing).split_views("\r\n").into_vec() == std::vector{"a"sv, "b"sv, ""sv});
+
+    // spans for anything other than characters
+    std::vector<int> v = {1, 2, 0, 3, 0, 0, 4};
+    auto ints = rvr::from(v).split_views(0);
+    STATIC_REQUIRE(std::same_as<rvr::reference_t<decltype(ints)>, std::span<int const>>);
+    CHECK(ints.map([](std::span<int const> piece){ return piece.size(); }).into_vec()
+          == std::vector<std::size_t>{2, 1, 0, 1});
+
+    // same pieces as split
+    std::string text = "the quick  brown fox jumps over the lazy dog ";
+    CHECK(rvr::from(text).split_views(' ').map([](std::string_view w){ return std::string(w); }).into_vec()
+          == rvr::from(text).split(' ').map(rvr::collect<std::string>).into_vec());
+}
+
+TEST_CASE("char_class", "[split]") {
+    constexpr auto space = rvr::char_class::space();
+    STATIC_REQUIRE(space.contains(' '));
+    STATIC_REQUIRE(space.contains('\r'));
+    STATIC_REQUIRE_FALSE(space.contains('x'));
+
+    auto const word = rvr::char_class::alnum() | rvr::char_class("_");
+    for (int b = 0; b != 256; ++b) {
+        bool const expected = std::isalnum(b) or b == '_';
+        CHECK(word.contains(static_cast<unsigned char>(b)) == expected);
+        CHECK((~word).contains(static_cast<unsigned char>(b)) == not expected);
+    }
+    CHECK((word & rvr::char_class("_-")) == rvr::char_class("_"));
+
+    std::bitset<256> bits;
+    bits.set(0).set(128).set(255);
+    auto const c = rvr::char_class(bits);
+    CHECK(c.contains(0));
+    CHECK(c.contains(128));
+    CHECK(c.contains(255));
+    CHECK_FALSE(c.contains(127));
+}
+
+TEST_CASE("tokenize", "[split]") {
+    using namespace std::literals;
+
+    std::string s = "GET /index.html\tHTTP/1.1\r\n";
+    auto r = rvr::from(s).tokenize(rvr::char_class::space());
+    STATIC_REQUIRE(std::same_as<rvr::reference_t<decltype(r)>, std::string_view>);
+    // like split, consecutive delimiters have empty pieces between them
+    CHECK(r.into_vec() == std::vector{"GET"sv, "/index.html"sv, "HTTP/1.1"sv, ""sv, ""sv});
+    r.reset();
+    CHECK(r.filter([](std::string_view w){ return not w.empty(); }).count() == 3);
+
+    std::string t = "a,b;c|d\te";
+    CHECK(rvr::tokenize(rvr::from(t), rvr::char_class::csv()).count() == 5);
+    CHECK(rvr::from(t).tokenize(rvr::char_class(",;")).into_vec() == std::vector{"a"sv, "b"sv, "c|d\te"sv});
+
+    // words are runs of alnum
+    std::string text = "it's 4:30, time for tea!";
+    auto words = rvr::from(text)
+        .tokenize(~rvr::char_class::alnum())
+        .filter([](std::string_view w){ return not w.empty(); });
+    CHECK(words.into_vec() == std::vector{"it"sv, "s"sv, "4"sv, "30"sv, "time"sv, "for"sv, "tea"sv});
+}
+
+TEST_CASE("find_in_class kernels", "[split]") {
+    std::vector<unsigned char> bytes(300);
+    for (std::size_t i = 0; i != bytes.size(); ++i) {
+        bytes[i] = static_cast<unsigned char>((i * 97) % 256);
+    }
+
+    for (auto cls : {rvr::char_class(), rvr::char_class::space(), rvr::char_class::alnum(),
+                     ~rvr::char_class::alnum(), rvr::char_class("\xff"), rvr::char_class("\x80")}) {
+        for (std::size_t start = 0; start < bytes.size(); start += 13) {
+            auto const p = bytes.data() + start;
+            auto const n = bytes.size() - start;
+            auto const expected = std::size_t(std::ranges::find_if(p, p + n, [&](unsigned char b){
+                return cls.contains(b);
+            }) - p);
+            CHECK(rvr::detail::simd::find_in_class(p, n, cls.rows.data()) == expected);
+            CHECK(rvr::detail::simd::find_in_class_scalar(p, n, cls.rows.data()) == expected);
+#if RVR_SIMD_X86
+            if (rvr::detail::simd::has_sse4()) {
+                CHECK(rvr::detail::simd::find_in_class_sse4(p, n, cls.rows.data()) == expected);
+            }
+            if (rvr::detail::simd::has_avx2()) {
+                CHECK(rvr::detail::simd::find_in_class_avx2(p, n, cls.rows.data()) == expected);
+            }
+#endif
+        }
+    }
+}
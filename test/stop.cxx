@@ -0,0 +1,101 @@
+#include "catch.hpp"
+
+#include <atomic>
+#include <numeric>
+#include <thread>
+#include <vector>
+#include <rivers/rivers.hpp>
+#include "test_utils.hpp"
+
+TEST_CASE("until_stopped", "[stop]") {
+    rvr::stop_source source;
+    int seen = 0;
+    rvr::seq(1'000'000).until_stopped(source.get_token()).for_each([&](int i){
+        ++seen;
+        if (i == 5000) {
+            source.request_stop();
+        }
+    });
+    // checked every chunk_size elements
+    CHECK(seen > 5000);
+    CHECK(seen <= 5001 + int(rvr::chunk_size));
+
+    // chunked rivers are checked before every chunk
+    std::vector<int> v(100'000, 1);
+    rvr::stop_source chunks;
+    auto r = rvr::from(v).until_stopped(chunks.get_token());
+    STATIC_REQUIRE(rvr::ChunkedRiver<decltype(r)>);
+    CHECK(r.sum() == 100'000);
+    chunks.request_stop();
+    CHECK(rvr::from(v).until_stopped(chunks.get_token()).sum() == 0);
+
+    // never stopped
+    CHECK(rvr::seq(100).until_stopped(rvr::stop_token()).sum() == 4950);
+}
+
+TEST_CASE("until_stopped from another thread", "[stop]") {
+    std::atomic<long long> seen = 0;
+    std::jthread worker([&](rvr::stop_token token){
+        rvr::seq(INT_MAX).until_stopped(token).for_each([&](int){ ++seen; });
+    });
+    while (seen.load() < 10'000) {
+        std::this_thread::yield();
+    }
+    worker.request_stop();
+    worker.join();
+    CHECK(seen.load() < INT_MAX);
+}
+
+TEST_CASE("parallel cancellation", "[stop][par]") {
+    for (std::size_t threads : {1, 2, 4}) {
+        rvr::thread_pool pool(threads);
+        std::atomic<long long> visited = 0;
+        auto counted = [&](int i){ ++visited; return i; };
+
+        // the match is right at the start, so the other pieces stop too
+        CHECK(rvr::seq(10'000'000).par(pool).map(counted).any([](int i){ return i == 10; }));
+        CHECK(visited.load() < 1'000'000);
+
+        visited = 0;
+        CHECK_FALSE(rvr::seq(10'000'000).par(pool).map(counted).all([](int i){ return i < 10; }));
+        CHECK(visited.load() < 1'000'000);
+        CHECK(rvr::seq(1000).par(pool).all([](int i){ return i < 1000; }));
+        CHECK(rvr::seq(1000).par(pool).none([](int i){ return i < 0; }));
+
+        // find gives the first match, even if a later piece finds one first
+        auto seven = [](int i){ return i % 1000 == 7; };
+        CHECK(rvr::seq(100'000).par(pool).find(seven) == Some(7));
+        CHECK(rvr::seq(100'000).par(pool).filter([](int i){ return i > 50'000; }).find(seven) == Some(50'007));
+        CHECK_FALSE(rvr::seq(100'000).par(pool).find([](int i){ return i < 0; }));
+
+        // take(n) keeps the order
+        visited = 0;
+        auto first = rvr::seq(10'000'000).par(pool).map(counted).filter([](int i){ return i % 3 == 0; }).take(5);
+        CHECK(first.into_vec() == std::vector{0, 3, 6, 9, 12});
+        CHECK(visited.load() < 1'000'000);
+        CHECK(rvr::seq(10).par(pool).take(20).sum() == 45);
+        CHECK(rvr::seq(10).par(pool).take(0).count() == 0);
+
+        // elements that a filter drops still count towards checking
+        auto rare = [](int i){ return i % 1'000'000 == 10; };
+        visited = 0;
+        CHECK(rvr::seq(10'000'000).par(pool).map(counted).filter(rare).any());
+        CHECK(visited.load() < 1'000'000);
+
+        visited = 0;
+        CHECK(rvr::seq(10'000'000).par(pool).map(counted).filter(rare).find(seven) == tl::nullopt);
+        CHECK(visited.load() == 10'000'000);
+        visited = 0;
+        CHECK(rvr::seq(10'000'000).par(pool).map(counted).filter(rare).find([](int){ return true; }) == Some(10));
+        CHECK(visited.load() < 1'000'000);
+
+        visited = 0;
+        CHECK(rvr::seq(10'000'000).par(pool).map(counted).filter(rare).take(2).into_vec() == std::vector{10, 1'000'010});
+        CHECK(visited.load() < 3'000'000);
+
+        // and a token stops the whole thing
+        rvr::stop_source source;
+        source.request_stop();
+        CHECK(rvr::seq(1'000'000).par(pool).until_stopped(source.get_token()).count() == 0);
+    }
+}
@@ -1,5 +1,13 @@
 #include "catch.hpp"
 
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+
 namespace Catch {
     template <typename T>
     struct StringMaker<tl::optional<T>> {
@@ -19,3 +27,48 @@ template <typename T>
 inline auto Some(T&& t) -> tl::optional<std::remove_cvref_t<T>> {
     return RVR_FWD(t);
 }
+
+// A file in the temp directory, created with the given contents and removed
+// on scope exit. Its name has our pid and a counter in it, so that tests
+// running at the same time don't collide.
+struct TempFile {
+    std::filesystem::path path;
+    std::string contents;
+    int fd = -1;
+
+    explicit TempFile(std::string initial = {})
+        : path(std::filesystem::temp_directory_path()
+               / ("rivers_test_" + std::to_string(::getpid()) + "_" + std::to_string(made++)))
+        , contents(std::move(initial))
+    {
+        std::ofstream(path, std::ios::binary) << contents;
+    }
+
+    TempFile(TempFile const&) = delete;
+    auto operator=(TempFile const&) -> TempFile& = delete;
+
+    ~TempFile() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        std::filesystem::remove(path);
+    }
+
+    // opens the file for writing, truncating it
+    auto open_for_writing() -> int {
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+        REQUIRE(fd >= 0);
+        return fd;
+    }
+
+    // what the file holds now
+    auto read() const -> std::string {
+        std::ifstream in(path, std::ios::binary);
+        std::ostringstream out;
+        out << in.rdbuf();
+        return out.str();
+    }
+
+private:
+    static inline std::atomic<unsigned> made = 0;
+};
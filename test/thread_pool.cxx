@@ -0,0 +1,42 @@
+#include "catch.hpp"
+
+#include <atomic>
+#include <vector>
+#include <rivers/rivers.hpp>
+#include "test_utils.hpp"
+
+TEST_CASE("thread pool runs every task", "[thread_pool]") {
+    STATIC_REQUIRE(rvr::executor<rvr::thread_pool>);
+
+    std::atomic<int> total = 0;
+    {
+        rvr::thread_pool pool(3);
+        CHECK(pool.concurrency() == 3);
+        for (int i = 1; i <= 1000; ++i) {
+            pool.execute([&total, i]{ total += i; });
+        }
+        // the destructor finishes the pending tasks
+    }
+    CHECK(total == 500'500);
+}
+
+TEST_CASE("thread pool nested fork join", "[thread_pool]") {
+    // every task forks more tasks and waits on them, which would deadlock a
+    // pool whose workers just blocked while waiting
+    rvr::thread_pool pool(2);
+    std::atomic<int> leaves = 0;
+
+    auto inner = [&](std::size_t){ ++leaves; };
+    auto outer = [&](std::size_t){ rvr::detail::fork_join(pool, 8, inner); };
+    rvr::detail::fork_join(pool, 8, outer);
+    CHECK(leaves == 64);
+
+    std::vector<long long> v(10'000, 1);
+    auto nested = [&](std::size_t){ return rvr::from(v).par(pool).sum(); };
+    CHECK(rvr::seq(8).par(pool).map([&](int){ return nested(0); }).sum() == 80'000);
+}
+
+TEST_CASE("pinned thread pool", "[thread_pool]") {
+    rvr::thread_pool pool(2, true);
+    CHECK(rvr::seq(1, 101).par(pool).sum() == 5050);
+}
@@ -0,0 +1,65 @@
+#include "catch.hpp"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <rivers/rivers.hpp>
+#include "test_utils.hpp"
+
+TEST_CASE("write_to", "[write]") {
+    TempFile out;
+    int const fd = out.open_for_writing();
+
+    SECTION("values") {
+        std::vector<int> ints = {1, 2, 3, 0x41424344};
+        CHECK(rvr::write_to(rvr::from(ints), fd) == 4u);
+        CHECK(rvr::write_to(rvr::seq(2), fd) == 2u);
+        auto const written = rvr::from_records<int>(out.path).into_vec();
+        CHECK(written == std::vector<int>{1, 2, 3, 0x41424344, 0, 1});
+    }
+
+    SECTION("strings") {
+        std::string big(200'000, 'b');
+        std::vector<std::string> strings = {"one", "", big, "two"};
+        CHECK(rvr::write_to(rvr::from(strings), fd) == 4u);
+        CHECK(out.read() == "one" + big + "two");
+    }
+
+    SECTION("views") {
+        std::string_view const text = "a,bb,,ccc";
+        CHECK(rvr::write_to(rvr::from(text).split_views(','), fd) == 4u);
+        CHECK(out.read() == "abbccc");
+    }
+
+    SECTION("blocks") {
+        // copying a file, a block at a time
+        std::string contents;
+        for (int i = 0; i != 30'000; ++i) {
+            contents += std::to_string(i) + ' ';
+        }
+        TempFile from;
+        CHECK(rvr::write_records(rvr::from(contents), from.path) == contents.size());
+        CHECK(rvr::write_to(rvr::read_ahead(from.path, {.block_size=16384}), fd) == 11u);
+        CHECK(out.read() == contents);
+    }
+
+    CHECK_THROWS_AS(rvr::write_to(rvr::of("x"), -1), std::system_error);
+}
+
+TEST_CASE("write_lines", "[write]") {
+    TempFile out;
+    int const fd = out.open_for_writing();
+
+    std::vector<std::string> words = {"apple", "", "pear"};
+    CHECK(rvr::write_lines(rvr::from(words), fd) == 3u);
+    CHECK(rvr::write_lines(rvr::seq(-1, 3), fd, ", ") == 4u);
+    CHECK(rvr::write_lines(rvr::of(0.5, 1e100), fd, ";") == 2u);
+    CHECK(out.read() == "apple\n\npear\n-1, 0, 1, 2, 0.5;1e+100;");
+
+    // lines round trip
+    std::string_view const text = "x\ny\n\nz\n";
+    TempFile copy;
+    int const copy_fd = copy.open_for_writing();
+    CHECK(rvr::write_lines(rvr::from(text).split_views('\n').take(4), copy_fd) == 4u);
+    CHECK(copy.read() == text);
+}